@@ -14,6 +14,7 @@
 //======================================================================================================
 #include <Application/Application.h>
 #include <Math/Math.h>
+#include <Misc/File.h>
 
 //======================================================================================================
 // 初期化処理
@@ -24,14 +25,13 @@ bool Application::OnInitialize()
 	_pRenderer = new Renderer();
 
 	// カメラの初期状態
+	_bCameraMatrix = false;
 	_CameraDistance = 9.65f;
 	Vector_Set(_CameraTarget, 0.0f, 3.0f, 0.0f, 1.0f);
 	Vector_Set(_CameraAngle, -0.29f, 1.76f, 0.0f, 0.0f);
 
 	// モデルの読み込み
-	ModelLoad("resources\\sponza.mbin");
-
-	return true;
+	return ModelLoad(_SceneFileName.c_str());
 }
 
 //======================================================================================================
@@ -47,6 +47,9 @@ void Application::OnFinalize()
 //======================================================================================================
 void Application::OnUpdate(fp32 FrameTime)
 {
+	// 行列が直接指定されている場合はそのまま使う
+	if (_bCameraMatrix) return;
+
 	//--------------------------------------------------------------------
 	// カメラの行列を作る
 	//--------------------------------------------------------------------
@@ -74,15 +77,20 @@ void Application::OnRendering(ColorBuffer* pColorBuffer, DepthBuffer* pDepthBuff
 	_TriangleCount = 0;
 
 	// 描画を開始する
+	_pRenderer->SetOcclusionCullingEnabled(_bOcclusionCulling);
+	_pRenderer->SetVisibilityBufferEnabled(_bVisibilityBuffer);
+	_pRenderer->SetTileShadingEnabled(_bTileShading);
+	_pRenderer->SetDepthOutputEnabled(_bDepthOutput);
 	_pRenderer->BeginDraw(pColorBuffer, pDepthBuffer, pGBuffer, _mView, _mProj);
 
 	_pRenderer->SetDirectionalLight(Vector3{ 1.0f, -2.0f, 5.0f });
 
 	// メッシュの描画
-	for (auto&& Mesh : _MeshDatas)
+	for (size_t i = 0; i < _MeshDatas.size(); ++i)
 	{
+		auto& Mesh = _MeshDatas[i];
 		_pRenderer->SetTexture(Mesh._Texture);
-		_pRenderer->DrawIndexed(&Mesh, Matrix::IDENTITY);
+		_pRenderer->DrawIndexed(&Mesh, Matrix::IDENTITY, _IsOccluders[i]);
 
 		_VertexCount += Mesh.GetVertexCount();
 		_TriangleCount += Mesh.GetIndexCount() / 3;
@@ -92,6 +100,25 @@ void Application::OnRendering(ColorBuffer* pColorBuffer, DepthBuffer* pDepthBuff
 	_pRenderer->EndDraw();
 }
 
+//======================================================================================================
+// カメラの設定
+//======================================================================================================
+void Application::SetCamera(const CameraPose& Pose)
+{
+	_bCameraMatrix = Pose.bMatrix;
+	if (Pose.bMatrix)
+	{
+		_mView = Pose.mView;
+		_mProj = Pose.mProj;
+	}
+	else
+	{
+		_CameraDistance = Pose.Distance;
+		_CameraAngle = Pose.Angle;
+		_CameraTarget = Pose.Target;
+	}
+}
+
 //======================================================================================================
 // マウス左ドラッグ
 //======================================================================================================
@@ -131,7 +158,7 @@ void Application::OnWheelMouseDrag(int32 x, int32 y)
 //======================================================================================================
 // ファイルの読み込み処理
 //======================================================================================================
-void Application::ModelLoad(const char* pFileName)
+bool Application::ModelLoad(const char* pFileName)
 {
 	// 同一頂点をマージするためのローカル関数
 	std::map<VertexData, uint16> VertexMap;
@@ -157,7 +184,7 @@ void Application::ModelLoad(const char* pFileName)
 
 	// ファイルパスの作成
 	std::string FullPath = pFileName;
-	size_t path_i = FullPath.find_last_of("\\") + 1;
+	size_t path_i = FullPath.find_last_of("\\/") + 1;
 	size_t ext_i = FullPath.find_last_of(".");
 	std::string Dir = FullPath.substr(0, path_i);
 	std::string ExtName = FullPath.substr(ext_i, FullPath.size() - ext_i);
@@ -165,16 +192,16 @@ void Application::ModelLoad(const char* pFileName)
 
 	_MeshDatas = std::vector<MeshData>();
 
+	bool bSucceeded = false;
+
 	// メッシュファイルを読み込み
-	HANDLE hFile = ::CreateFileA(pFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-	if (hFile != INVALID_HANDLE_VALUE)
+	File MeshFile;
+	if (MeshFile.Open(pFileName, "rb"))
 	{
-		DWORD ReadedBytes;
-
 		MeshFileBinaryHead Head;
-		::ReadFile(hFile, &Head, sizeof(Head), &ReadedBytes, nullptr);
+		const auto ReadedBytes = MeshFile.Read(&Head, sizeof(Head));
 
-		if (Head.GUID == 'MBIN')
+		if ((ReadedBytes == sizeof(Head)) && (Head.GUID == 'MBIN'))
 		{
 			_MeshDatas.resize(Head.MeshCount);
 			for (auto iMesh = 0U; iMesh < Head.MeshCount; ++iMesh)
@@ -182,23 +209,63 @@ void Application::ModelLoad(const char* pFileName)
 				auto& Dst = _MeshDatas[iMesh];
 
 				MeshFileBinary MeshBin;
-				::ReadFile(hFile, &MeshBin, sizeof(MeshBin), &ReadedBytes, nullptr);
+				MeshFile.Read(&MeshBin, sizeof(MeshBin));
 
 				// テクスチャの読み込み
 				Dst._Texture.Load((Dir + MeshBin.TextureName + ".dds").c_str());
 
 				// ジオメトリデータ読み込み
 				std::vector<VertexData> VertexDatas(MeshBin.TriangleVertexCount);
-				::ReadFile(hFile, &(VertexDatas[0]), sizeof(VertexData) * MeshBin.TriangleVertexCount, &ReadedBytes, nullptr);
+				MeshFile.Read(&(VertexDatas[0]), sizeof(VertexData) * MeshBin.TriangleVertexCount);
 
 				// 頂点データ＆頂点インデックス
 				for (auto&& v : VertexDatas)
 				{
 					Dst._Index.push_back(AddVertex(v, Dst));
 				}
+
+				Dst.UpdateBounds();
+				Dst.BuildClusters();
+				Dst.BuildSoA();
 			}
+
+			SelectOccluders();
+			bSucceeded = true;
 		}
 
-		::CloseHandle(hFile);
+		MeshFile.Close();
+	}
+
+	return bSucceeded;
+}
+
+//======================================================================================================
+// オクルージョンカリングの遮蔽物にするメッシュを選ぶ
+//  シーン全体に対して大きいメッシュ（壁や床など）だけを遮蔽物にする
+//======================================================================================================
+void Application::SelectOccluders()
+{
+	static const fp32 OCCLUDER_SIZE_RATE = 0.25f;
+
+	const auto GetSize = [](const Vector3& Min, const Vector3& Max)
+	{
+		return std::max(Max.x - Min.x, std::max(Max.y - Min.y, Max.z - Min.z));
+	};
+
+	Vector3 SceneMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+	Vector3 SceneMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (auto&& Mesh : _MeshDatas)
+	{
+		Vector_Min(SceneMin, SceneMin, Mesh._BoundingMin);
+		Vector_Max(SceneMax, SceneMax, Mesh._BoundingMax);
+	}
+
+	const auto MinSize = GetSize(SceneMin, SceneMax) * OCCLUDER_SIZE_RATE;
+
+	_IsOccluders.resize(_MeshDatas.size());
+	for (size_t i = 0; i < _MeshDatas.size(); ++i)
+	{
+		const auto& Mesh = _MeshDatas[i];
+		_IsOccluders[i] = GetSize(Mesh._BoundingMin, Mesh._BoundingMax) >= MinSize;
 	}
 }
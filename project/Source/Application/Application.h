@@ -20,6 +20,19 @@
 #include <Renderer/Renderer.h>
 #include <Renderer/FrameBuffer.h>
 
+//======================================================================================================
+// カメラの指定（注視点まわりの回転か、ビュー・プロジェクション行列の直接指定）
+//======================================================================================================
+struct CameraPose
+{
+	bool		bMatrix;
+	fp32		Distance;
+	Vector4		Angle;
+	Vector4		Target;
+	Matrix		mView;
+	Matrix		mProj;
+};
+
 //======================================================================================================
 //
 //======================================================================================================
@@ -27,21 +40,36 @@ class Application
 {
 	Renderer*				_pRenderer;
 	std::vector<MeshData>	_MeshDatas;
+	std::vector<bool>		_IsOccluders;
+	std::string				_SceneFileName;
 	Matrix					_mView;
 	Matrix					_mProj;
+	bool					_bCameraMatrix;
 	fp32					_CameraDistance;
 	Vector4					_CameraAngle;
 	Vector4					_CameraTarget;
 	uint32					_VertexCount;
 	uint32					_TriangleCount;
+	bool					_bOcclusionCulling;
+	bool					_bVisibilityBuffer;
+	bool					_bTileShading;
+	bool					_bDepthOutput;
 
 private:
-	void ModelLoad(const char* pFileName);
+	bool ModelLoad(const char* pFileName);
+	void SelectOccluders();
 
 public:
-	Application() {}
+	Application() : _SceneFileName("resources/sponza.mbin"), _bCameraMatrix(false), _bOcclusionCulling(false), _bVisibilityBuffer(false), _bTileShading(false), _bDepthOutput(false) {}
 	~Application() {}
 
+	void SetSceneFileName(const char* pFileName) { _SceneFileName = pFileName; }
+	void SetCamera(const CameraPose& Pose);
+	void SetOcclusionCulling(bool IsEnabled) { _bOcclusionCulling = IsEnabled; }
+	void SetVisibilityBuffer(bool IsEnabled) { _bVisibilityBuffer = IsEnabled; }
+	void SetTileShading(bool IsEnabled) { _bTileShading = IsEnabled; }
+	void SetDepthOutput(bool IsEnabled) { _bDepthOutput = IsEnabled; }
+
 	bool OnInitialize();
 	void OnFinalize();
 
@@ -0,0 +1,179 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Framework/Framework.h>
+#include <Platform/BatchPlatform.h>
+#include <Application/Application.h>
+#include <Misc/File.h>
+#include <TaskSystem/TaskSystem.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static Application _App;
+
+//======================================================================================================
+// カメラリストの読み込み
+//  # から始まる行と空行は無視する
+//  orbit  Distance AngleX AngleY TargetX TargetY TargetZ    （Applicationのマウス操作と同じ注視点まわりの回転）
+//  matrix View[16] Proj[16]                                  （行列を x.x x.y x.z x.w y.x ... の順で直接指定）
+//======================================================================================================
+static bool LoadCameraPoses(const char* pFileName, std::vector<CameraPose>& Poses)
+{
+	File CameraFile;
+	if (!CameraFile.Open(pFileName, "rt"))
+	{
+		fprintf(stderr, "failed to open %s\n", pFileName);
+		return false;
+	}
+
+	char Line[1024];
+	int32 LineNo = 0;
+	while (CameraFile.ReadLine(Line, sizeof(Line)))
+	{
+		LineNo++;
+
+		char Type[16];
+		int32 Offset = 0;
+		if (sscanf(Line, " %15s%n", Type, &Offset) != 1) continue;
+		if (Type[0] == '#') continue;
+
+		CameraPose Pose = {};
+		const char* pArgs = Line + Offset;
+		if (strcmp(Type, "orbit") == 0)
+		{
+			Pose.bMatrix = false;
+			Pose.Target.w = 1.0f;
+			const auto Count = sscanf(pArgs, "%f %f %f %f %f %f",
+				&Pose.Distance,
+				&Pose.Angle.x, &Pose.Angle.y,
+				&Pose.Target.x, &Pose.Target.y, &Pose.Target.z);
+			if (Count != 6)
+			{
+				fprintf(stderr, "%s(%d): orbit needs 6 values\n", pFileName, LineNo);
+				return false;
+			}
+		}
+		else if (strcmp(Type, "matrix") == 0)
+		{
+			Pose.bMatrix = true;
+			fp32* pValues[2] = { &Pose.mView.x.x, &Pose.mProj.x.x };
+			for (auto* pValue : pValues)
+			{
+				for (int32 i = 0; i < 16; ++i)
+				{
+					int32 Length = 0;
+					if (sscanf(pArgs, "%f%n", &pValue[i], &Length) != 1)
+					{
+						fprintf(stderr, "%s(%d): matrix needs 32 values\n", pFileName, LineNo);
+						return false;
+					}
+					pArgs += Length;
+				}
+			}
+		}
+		else
+		{
+			fprintf(stderr, "%s(%d): unknown camera type '%s'\n", pFileName, LineNo, Type);
+			return false;
+		}
+
+		Poses.push_back(Pose);
+	}
+
+	return true;
+}
+
+//======================================================================================================
+// usage: RasterizerBatch [--trace Trace.json] Scene.mbin Cameras.txt [OutputDirectory]
+//  カメラリストの各カメラから描画して OutputDirectory/frame_00000.bmp ... に書き出す
+//  OutputDirectory を省略すると書き出さずに描画速度だけを計測する
+//  --trace を指定すると全フレームのジョブの実行記録を Chrome trace 形式で書き出す
+//======================================================================================================
+int32 main(int32 argc, char* argv[])
+{
+	const char* pTraceFileName = nullptr;
+	std::vector<const char*> Args;
+	for (int32 i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+		{
+			pTraceFileName = argv[++i];
+		}
+		else
+		{
+			Args.push_back(argv[i]);
+		}
+	}
+
+	if (Args.size() < 2)
+	{
+		fprintf(stderr, "usage: %s [--trace Trace.json] Scene.mbin Cameras.txt [OutputDirectory]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<CameraPose> Poses;
+	if (!LoadCameraPoses(Args[1], Poses))
+	{
+		return 1;
+	}
+	if (Poses.empty())
+	{
+		fprintf(stderr, "%s: no camera\n", Args[1]);
+		return 1;
+	}
+
+	_App.SetSceneFileName(Args[0]);
+
+	if (pTraceFileName != nullptr)
+	{
+		// 最後のバッファを出力するための1回を含める
+		TaskSystem::Instance().BeginTrace(pTraceFileName, int32(Poses.size()) + 1);
+	}
+
+	BatchPlatform Platform(Poses, (Args.size() > 2) ? Args[2] : nullptr);
+	Framework Framework(Platform, _App);
+	if (Framework.Run() != 0)
+	{
+		fprintf(stderr, "failed to load %s\n", Args[0]);
+		return 1;
+	}
+
+	const auto Second = Platform.GetElapsedSecond();
+	printf("%d frames  %.3f sec  %.2f frames/sec\n",
+		Platform.GetFrameCount(),
+		Second,
+		(Second > 0.0) ? fp64(Platform.GetFrameCount()) / Second : 0.0);
+
+	// フェーズとスレッドごとの平均時間
+	const auto Profile = Platform.GetAverageProfile();
+	for (auto&& Phase : Profile.Phases)
+	{
+		printf("  %-12s wall %8.3f ms  busy %8.3f ms  jobs %d\n",
+			Phase.pName != nullptr ? Phase.pName : "-",
+			Phase.WallTime / 1000.0,
+			Phase.BusyTime / 1000.0,
+			Phase.JobCount);
+	}
+	for (auto&& Worker : Profile.Workers)
+	{
+		printf("  core %-7d busy %8.3f ms  barrier %8.3f ms  idle %8.3f ms\n",
+			Worker.CoreNo,
+			Worker.BusyTime / 1000.0,
+			Worker.BarrierTime / 1000.0,
+			Worker.IdleTime / 1000.0);
+	}
+
+	return 0;
+}
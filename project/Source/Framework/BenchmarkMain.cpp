@@ -0,0 +1,359 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Framework/Framework.h>
+#include <Platform/BatchPlatform.h>
+#include <Application/Application.h>
+#include <Misc/File.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static Application _App;
+
+//======================================================================================================
+// 固定のカメラパス
+//  tは0.0～1.0でフレーム番号だけから決まるので毎回同じ絵になる
+//  値はApplicationの初期カメラ（注視点(0,3,0)、距離9.65）を基準にしている
+//======================================================================================================
+struct Scenario
+{
+	const char*	pName;
+	void		(*pGetPose)(fp32 t, CameraPose& Pose);
+};
+
+// 床に張り付くように近づいて横に移動する（少数の大きな三角形が画面全体を覆う）
+static void GetPose_NearWall(fp32 t, CameraPose& Pose)
+{
+	Pose.Distance = 0.6f;
+	Vector_Set(Pose.Angle, -1.2f, PI * 2.0f * t, 0.0f, 0.0f);
+	Vector_Set(Pose.Target, -4.0f + 8.0f * t, 0.0f, 0.0f, 1.0f);
+}
+
+// 初期カメラより少し引いて左右に振る（シーン全体が見える）
+static void GetPose_Wide(fp32 t, CameraPose& Pose)
+{
+	Pose.Distance = 12.0f;
+	Vector_Set(Pose.Angle, -0.29f, 1.76f + 0.8f * sinf(PI * 2.0f * t), 0.0f, 0.0f);
+	Vector_Set(Pose.Target, 0.0f, 3.0f, 0.0f, 1.0f);
+}
+
+// 床すれすれの高さで一周する（床が細長い三角形になる）
+static void GetPose_Grazing(fp32 t, CameraPose& Pose)
+{
+	Pose.Distance = 14.0f;
+	Vector_Set(Pose.Angle, -0.04f, PI * 2.0f * t, 0.0f, 0.0f);
+	Vector_Set(Pose.Target, 0.0f, 0.5f, 0.0f, 1.0f);
+}
+
+// 外側から全体を見ながら一周する（壁や柱が何重にも重なる）
+static void GetPose_Overdraw(fp32 t, CameraPose& Pose)
+{
+	Pose.Distance = 40.0f;
+	Vector_Set(Pose.Angle, -0.15f, PI * 2.0f * t, 0.0f, 0.0f);
+	Vector_Set(Pose.Target, 0.0f, 3.0f, 0.0f, 1.0f);
+}
+
+static const Scenario _Scenarios[] = {
+	{ "near-wall",	GetPose_NearWall },
+	{ "wide",		GetPose_Wide },
+	{ "grazing",	GetPose_Grazing },
+	{ "overdraw",	GetPose_Overdraw },
+};
+static const int32 SCENARIO_COUNT = int32(sizeof(_Scenarios) / sizeof(_Scenarios[0]));
+
+//======================================================================================================
+// 計測値の集計（ミリ秒）
+//======================================================================================================
+struct Result
+{
+	std::string	Scenario;
+	std::string	Phase;
+	fp64		Min;
+	fp64		Median;
+	fp64		P99;
+};
+
+static Result MakeResult(const char* pScenario, const char* pPhase, std::vector<fp64> Times)
+{
+	Result Dst = { pScenario, pPhase, 0.0, 0.0, 0.0 };
+	if (Times.empty()) return Dst;
+
+	std::sort(Times.begin(), Times.end());
+	const auto Count = Times.size();
+	// p99は nearest-rank で求める
+	const auto P99Index = std::min(Count - 1, (Count * 99 + 99) / 100 - 1);
+	Dst.Min = Times.front() / 1000.0;
+	Dst.Median = ((Count & 1) ? Times[Count / 2] : (Times[Count / 2 - 1] + Times[Count / 2]) * 0.5) / 1000.0;
+	Dst.P99 = Times[P99Index] / 1000.0;
+	return Dst;
+}
+
+//======================================================================================================
+// 結果の読み書き
+//  1行に1つの結果を出しておき、比較するときは同じ形式の行だけを読む
+//======================================================================================================
+static const char* RESULT_FORMAT = "{\"scenario\":\"%s\",\"phase\":\"%s\",\"min\":%.4f,\"median\":%.4f,\"p99\":%.4f}";
+static const char* RESULT_SCAN_FORMAT = " {\"scenario\":\"%63[^\"]\",\"phase\":\"%63[^\"]\",\"min\":%lf,\"median\":%lf,\"p99\":%lf}";
+
+static bool SaveResults(const char* pFileName, const std::vector<Result>& Results, int32 FrameCount, int32 WarmupCount)
+{
+	File Output;
+	if (!Output.Open(pFileName, "wt"))
+	{
+		fprintf(stderr, "failed to open %s\n", pFileName);
+		return false;
+	}
+
+	char Line[512];
+	auto Write = [&](const char* pText) {
+		Output.Write(pText, strlen(pText));
+	};
+
+	snprintf(Line, sizeof(Line), "{\n\"frames\":%d,\n\"warmup\":%d,\n\"threads\":%d,\n\"unit\":\"ms\",\n\"results\":[\n",
+		FrameCount, WarmupCount, int32(std::thread::hardware_concurrency()));
+	Write(Line);
+	for (size_t i = 0; i < Results.size(); ++i)
+	{
+		const auto& Src = Results[i];
+		snprintf(Line, sizeof(Line), RESULT_FORMAT, Src.Scenario.c_str(), Src.Phase.c_str(), Src.Min, Src.Median, Src.P99);
+		Write(Line);
+		Write((i + 1 < Results.size()) ? ",\n" : "\n");
+	}
+	Write("]\n}\n");
+	return true;
+}
+
+static bool LoadResults(const char* pFileName, std::vector<Result>& Results)
+{
+	File Input;
+	if (!Input.Open(pFileName, "rt"))
+	{
+		fprintf(stderr, "failed to open %s\n", pFileName);
+		return false;
+	}
+
+	char Line[512];
+	while (Input.ReadLine(Line, sizeof(Line)))
+	{
+		char Scenario[64], Phase[64];
+		Result Src;
+		if (sscanf(Line, RESULT_SCAN_FORMAT, Scenario, Phase, &Src.Min, &Src.Median, &Src.P99) != 5) continue;
+
+		Src.Scenario = Scenario;
+		Src.Phase = Phase;
+		Results.push_back(Src);
+	}
+
+	return true;
+}
+
+//======================================================================================================
+// usage: RasterizerBenchmark [--scene Scene.mbin] [--frames N] [--warmup N] [--occlusion] [--visibility] [--tile-shading]
+//                            [--output Result.json] [--baseline Baseline.json] [--threshold Percent]
+//  固定のカメラパスをそれぞれ N フレーム描画して、フェーズごとの min/median/p99 を出力する
+//  --baseline を指定すると median が threshold（%）より遅くなった項目を報告して 2 を返す
+//  --occlusion を指定するとオクルージョンカリングを有効にする
+//  --visibility を指定するとGBufferの代わりに可視バッファを使う
+//  --tile-shading を指定するとタイルごとにラスタライズとシェーディングを続けて行う
+//======================================================================================================
+int32 main(int32 argc, char* argv[])
+{
+	const char* pSceneFileName = nullptr;
+	const char* pOutputFileName = nullptr;
+	const char* pBaselineFileName = nullptr;
+	int32 FrameCount = 60;
+	int32 WarmupCount = 5;
+	fp64 Threshold = 10.0;
+
+	for (int32 i = 1; i < argc; ++i)
+	{
+		const bool HasValue = (i + 1 < argc);
+		if (HasValue && (strcmp(argv[i], "--scene") == 0))
+		{
+			pSceneFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--occlusion") == 0)
+		{
+			_App.SetOcclusionCulling(true);
+		}
+		else if (strcmp(argv[i], "--visibility") == 0)
+		{
+			_App.SetVisibilityBuffer(true);
+		}
+		else if (strcmp(argv[i], "--tile-shading") == 0)
+		{
+			_App.SetTileShading(true);
+		}
+		else if (HasValue && (strcmp(argv[i], "--frames") == 0))
+		{
+			FrameCount = std::max(1, atoi(argv[++i]));
+		}
+		else if (HasValue && (strcmp(argv[i], "--warmup") == 0))
+		{
+			WarmupCount = std::max(0, atoi(argv[++i]));
+		}
+		else if (HasValue && (strcmp(argv[i], "--output") == 0))
+		{
+			pOutputFileName = argv[++i];
+		}
+		else if (HasValue && (strcmp(argv[i], "--baseline") == 0))
+		{
+			pBaselineFileName = argv[++i];
+		}
+		else if (HasValue && (strcmp(argv[i], "--threshold") == 0))
+		{
+			Threshold = atof(argv[++i]);
+		}
+		else
+		{
+			fprintf(stderr, "usage: %s [--scene Scene.mbin] [--frames N] [--warmup N] [--occlusion] [--visibility] [--tile-shading] [--output Result.json] [--baseline Baseline.json] [--threshold Percent]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// すべてのシナリオのカメラを並べて1回で描画する
+	// 各シナリオの先頭で最初のカメラのままウォームアップする
+	//--------------------------------------------------------------------------
+	const int32 ScenarioFrameCount = WarmupCount + FrameCount;
+	std::vector<CameraPose> Poses;
+	for (int32 i = 0; i < SCENARIO_COUNT; ++i)
+	{
+		for (int32 j = 0; j < ScenarioFrameCount; ++j)
+		{
+			CameraPose Pose = {};
+			Pose.bMatrix = false;
+			_Scenarios[i].pGetPose(fp32(std::max(0, j - WarmupCount)) / fp32(FrameCount), Pose);
+			Poses.push_back(Pose);
+		}
+	}
+
+	if (pSceneFileName != nullptr)
+	{
+		_App.SetSceneFileName(pSceneFileName);
+	}
+
+	BatchPlatform Platform(Poses, nullptr);
+	Framework Framework(Platform, _App);
+	if (Framework.Run() != 0)
+	{
+		fprintf(stderr, "failed to load scene\n");
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// シナリオとフェーズごとに集計する
+	//--------------------------------------------------------------------------
+	const auto& Profiles = Platform.GetProfiles();
+	if (int32(Profiles.size()) < SCENARIO_COUNT * ScenarioFrameCount)
+	{
+		fprintf(stderr, "profile is not available\n");
+		return 1;
+	}
+
+	std::vector<Result> Results;
+	for (int32 i = 0; i < SCENARIO_COUNT; ++i)
+	{
+		const auto First = i * ScenarioFrameCount + WarmupCount;
+		const auto Last = First + FrameCount;
+
+		std::vector<fp64> Times;
+		for (int32 j = First; j < Last; ++j)
+		{
+			Times.push_back(Profiles[j].FrameTime);
+		}
+		Results.push_back(MakeResult(_Scenarios[i].pName, "Frame", Times));
+
+		// フェーズの並びはフレームごとに変わることがあるので名前で対応を取る
+		std::vector<std::string> PhaseNames;
+		for (int32 j = First; j < Last; ++j)
+		{
+			for (auto&& Phase : Profiles[j].Phases)
+			{
+				if (Phase.pName == nullptr) continue;
+				if (std::find(PhaseNames.begin(), PhaseNames.end(), Phase.pName) != PhaseNames.end()) continue;
+
+				PhaseNames.push_back(Phase.pName);
+			}
+		}
+
+		for (auto&& Name : PhaseNames)
+		{
+			Times.clear();
+			for (int32 j = First; j < Last; ++j)
+			{
+				for (auto&& Phase : Profiles[j].Phases)
+				{
+					if ((Phase.pName != nullptr) && (Name == Phase.pName))
+					{
+						Times.push_back(Phase.WallTime);
+						break;
+					}
+				}
+			}
+			Results.push_back(MakeResult(_Scenarios[i].pName, Name.c_str(), Times));
+		}
+	}
+
+	printf("%-10s %-10s %10s %10s %10s   (ms, %d frames)\n", "scenario", "phase", "min", "median", "p99", FrameCount);
+	for (auto&& Src : Results)
+	{
+		printf("%-10s %-10s %10.3f %10.3f %10.3f\n", Src.Scenario.c_str(), Src.Phase.c_str(), Src.Min, Src.Median, Src.P99);
+	}
+
+	if ((pOutputFileName != nullptr) && !SaveResults(pOutputFileName, Results, FrameCount, WarmupCount))
+	{
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// 基準の結果と median を比較する
+	//--------------------------------------------------------------------------
+	if (pBaselineFileName != nullptr)
+	{
+		std::vector<Result> Baselines;
+		if (!LoadResults(pBaselineFileName, Baselines))
+		{
+			return 1;
+		}
+
+		int32 RegressionCount = 0;
+		for (auto&& Src : Results)
+		{
+			for (auto&& Base : Baselines)
+			{
+				if ((Base.Scenario != Src.Scenario) || (Base.Phase != Src.Phase)) continue;
+
+				const auto Limit = Base.Median * (1.0 + Threshold / 100.0);
+				if (Src.Median > Limit)
+				{
+					fprintf(stderr, "regression: %s %s median %.3f ms > baseline %.3f ms (+%.1f%%)\n",
+						Src.Scenario.c_str(), Src.Phase.c_str(), Src.Median, Base.Median,
+						(Src.Median / Base.Median - 1.0) * 100.0);
+					RegressionCount++;
+				}
+			}
+		}
+
+		if (RegressionCount > 0)
+		{
+			return 2;
+		}
+		printf("no regression against %s (threshold %.1f%%)\n", pBaselineFileName, Threshold);
+	}
+
+	return 0;
+}
@@ -12,6 +12,7 @@
 //======================================================================================================
 //
 //======================================================================================================
+#include <Framework/Framework.h>
 #include <Application/Application.h>
 #include <Renderer/FrameBuffer.h>
 #include <Misc/Timer.h>
@@ -20,267 +21,52 @@
 //======================================================================================================
 //
 //======================================================================================================
-class DIBBuffer
+Framework::Framework(IPlatform& Platform, Application& App)
+	: _Platform(Platform)
+	, _App(App)
 {
-private:
-	Color*	_pSurface;
-	int32	_Width;
-	int32	_Height;
-	HBITMAP	_hBitmap;
-	HWND	_hWnd;
-	HDC		_hWindowDC;
-	HDC		_hSurfaceDC;
-
-public:
-	Color* Surface()
-	{
-		return _pSurface;
-	}
-	HDC SurfaceDC()
-	{
-		return _hSurfaceDC;
-	}
-	int32 Width()
-	{
-		return _Width;
-	}
-	int32 Height()
-	{
-		return _Height;
-	}
-	void Create(HWND hWnd, HDC hWindowDC, int32 w, int32 h)
-	{
-		_Width = w;
-		_Height = h;
-
-		BITMAPINFOHEADER BmpInfoHeader = { sizeof(BITMAPINFOHEADER) };
-		BmpInfoHeader.biWidth = +_Width;
-		BmpInfoHeader.biHeight = -_Height;	// BMPはYが下から上だけど高さをマイナスにすると上から下になる
-		BmpInfoHeader.biPlanes = 1;
-		BmpInfoHeader.biBitCount = 32;
-		BmpInfoHeader.biCompression = BI_RGB;
-
-		_hWnd = hWnd;
-		_hWindowDC = hWindowDC;
-		_hBitmap = ::CreateDIBSection(_hWindowDC, (BITMAPINFO*)&BmpInfoHeader, DIB_RGB_COLORS, (void**)&_pSurface, nullptr, 0);
-		_hSurfaceDC = ::CreateCompatibleDC(_hWindowDC);
-		::SelectObject(_hSurfaceDC, _hBitmap);
-	}
-	void Release()
-	{
-		::ReleaseDC(_hWnd, _hSurfaceDC);
-		::DeleteObject(_hBitmap);
-		::ReleaseDC(_hWnd, _hWindowDC);
-	}
-};
-
-//======================================================================================================
-//
-//======================================================================================================
-static Application _App;
-static bool _RequireSaveScene;
-
-//======================================================================================================
-//
-//======================================================================================================
-static void SaveToBMP(const wchar_t* pFileName, const FrameBuffer<Color>& DIBBuff)
-{
-	BITMAPINFOHEADER BmpIH = { sizeof(BITMAPINFOHEADER) };
-	BmpIH.biWidth = DIBBuff.GetWidth();
-	BmpIH.biHeight = DIBBuff.GetHeight();
-	BmpIH.biPlanes = 1;
-	BmpIH.biBitCount = 32;
-	BmpIH.biCompression = BI_RGB;
-
-	BITMAPFILEHEADER BmpH;
-	BmpH.bfType = 'MB';
-	BmpH.bfSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + sizeof(uint32) * BmpIH.biWidth * BmpIH.biHeight;
-	BmpH.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
-
-	HANDLE hFile = ::CreateFile(L"ScreenShot.bmp", GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-	if (hFile != INVALID_HANDLE_VALUE)
-	{
-		DWORD WriteSize;
-		::WriteFile(hFile, &BmpH, sizeof(BITMAPFILEHEADER), &WriteSize, nullptr);
-		::WriteFile(hFile, &BmpIH, sizeof(BITMAPINFOHEADER), &WriteSize, nullptr);
-		const Color* pPixel = DIBBuff.GetPixelPointer() + (BmpIH.biWidth * BmpIH.biHeight);
-		for (int32 y = 0; y < BmpIH.biHeight; ++y)
-		{
-			pPixel -= BmpIH.biWidth;
-			::WriteFile(hFile, pPixel, sizeof(uint32) * BmpIH.biWidth, &WriteSize, nullptr);
-		}
-		::CloseHandle(hFile);
-	}
 }
 
 //======================================================================================================
 //
 //======================================================================================================
-LRESULT CALLBACK MessageProc(HWND hWnd, uint32 Msg, WPARAM wParam, LPARAM lParam)
+Framework::~Framework()
 {
-	static POINT CursorPosition;
-
-	switch (Msg)
-	{
-		//---------------------------------------------
-	case WM_LBUTTONDOWN:
-	case WM_RBUTTONDOWN:
-	case WM_MBUTTONDOWN:
-		::SetCapture(hWnd);
-		::GetCursorPos(&CursorPosition);
-		break;
-		//---------------------------------------------
-	case WM_LBUTTONUP:
-	case WM_RBUTTONUP:
-	case WM_MBUTTONUP:
-		::ReleaseCapture();
-		break;
-		//---------------------------------------------
-	case WM_MOUSEMOVE:
-		{
-			POINT NewCursorPosition;
-			::GetCursorPos(&NewCursorPosition);
-			const int32 mx = NewCursorPosition.x - CursorPosition.x;
-			const int32 my = NewCursorPosition.y - CursorPosition.y;
-			CursorPosition = NewCursorPosition;
-			if (wParam & MK_LBUTTON)
-			{
-				_App.OnLefeMouseDrag(mx, my);
-			}
-			if (wParam & MK_RBUTTON)
-			{
-				_App.OnRightMouseDrag(mx, my);
-			}
-			if (wParam & MK_MBUTTON)
-			{
-				_App.OnWheelMouseDrag(mx, my);
-			}
-		}
-		break;
-		//---------------------------------------------
-	case WM_KEYDOWN:
-		switch (wParam)
-		{
-		case VK_ESCAPE:
-			::SendMessage(hWnd, WM_CLOSE, 0, 0);
-			break;
-		case VK_RETURN:
-			_RequireSaveScene = true;
-			break;
-		}
-		break;
-		//---------------------------------------------
-	case WM_CREATE:
-		::SetCursor(LoadCursor(nullptr, IDC_ARROW));
-		break;
-		//---------------------------------------------
-	case WM_CLOSE:
-		::PostMessage(hWnd, WM_DESTROY, 0, 0);
-		break;
-		//---------------------------------------------
-	case WM_DESTROY:
-		PostQuitMessage(0);
-		break;
-	}
-
-	return DefWindowProc(hWnd, Msg, wParam, lParam);
 }
 
 //======================================================================================================
 //
 //======================================================================================================
-int32 WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int32)
+int32 Framework::Run()
 {
-	wchar_t ModuleFileName[MAX_PATH];
-	WNDCLASS WindowClass;
-	HWND hWnd;
-	MSG Msg;
 	Timer Timer;
 
-	//---------------------------------------------------------
-	// カレントディレクトリ設定
-	//---------------------------------------------------------
-	GetModuleFileName(hInstance, ModuleFileName, MAX_PATH);
-	auto Length = (int32)wcslen(ModuleFileName);
-	while (ModuleFileName[Length] != L'\\')
+	const auto PAGE_COUNT = 2;
+	auto BufferPage = 0;
+
+	//--------------------------------------------------------------------------
+	// 出力先の生成
+	//--------------------------------------------------------------------------
+	if (!_Platform.Initialize(&_App, SCREEN_WIDTH, SCREEN_HEIGHT, PAGE_COUNT))
 	{
-		if (--Length < 0)
-		{
-			break;
-		}
+		return 1;
 	}
-	ModuleFileName[Length + 1] = L'\0';
-	SetCurrentDirectory(ModuleFileName);
-
-	//------------------------------------------------------------
-	// ウィンドウクラス
-	//------------------------------------------------------------
-	WindowClass.style = CS_DBLCLKS;
-	WindowClass.lpfnWndProc = MessageProc;
-	WindowClass.cbClsExtra = 0;
-	WindowClass.cbWndExtra = 0;
-	WindowClass.hInstance = hInstance;
-	WindowClass.hIcon = nullptr;
-	WindowClass.hCursor = LoadCursor(nullptr, IDC_ARROW);
-	WindowClass.hbrBackground = (HBRUSH)GetStockObject(WHITE_BRUSH);
-	WindowClass.lpszMenuName = nullptr;
-	WindowClass.lpszClassName = APPLICATION_TITLE;
-	RegisterClass(&WindowClass);
-
-	//------------------------------------------------------------
-	// ウィンドウ生成
-	//------------------------------------------------------------
-	auto x = 0;
-	auto y = 0;
-	auto w = SCREEN_WIDTH;
-	auto h = SCREEN_HEIGHT;
-	auto Style = WS_POPUP | WS_CAPTION | WS_SYSMENU;
-	RECT Rect = { 0, 0, w, h };
-	::AdjustWindowRect(&Rect, Style, FALSE);
-	w = Rect.right - Rect.left;
-	h = Rect.bottom - Rect.top;
-	x = ::GetSystemMetrics(SM_CXSCREEN) / 2 - w / 2;
-	y = ::GetSystemMetrics(SM_CYSCREEN) / 2 - h / 2;
-
-	hWnd = ::CreateWindowEx(
-		WS_EX_APPWINDOW,
-		APPLICATION_TITLE,
-		APPLICATION_TITLE,
-		Style,
-		x, y, w, h,
-		nullptr,
-		nullptr,
-		hInstance,
-		nullptr);
-
-	::ShowWindow(hWnd, SW_NORMAL);
-	::UpdateWindow(hWnd);
 
 	//--------------------------------------------------------------------------
 	// 初期化処理
 	//--------------------------------------------------------------------------
 	if (!_App.OnInitialize())
 	{
+		_Platform.Finalize();
 		return 1;
 	}
 
 	//--------------------------------------------------------------------------
 	// バッファ生成
 	//--------------------------------------------------------------------------
-	auto hWindowDC = ::GetDC(hWnd);
-
-	const auto PAGE_COUNT = 2;
-	auto BufferPage = 0;
-
-	DIBBuffer DIBBuffer[PAGE_COUNT];
-	for (auto i = 0; i < PAGE_COUNT; ++i)
-	{
-		DIBBuffer[i].Create(hWnd, hWindowDC, SCREEN_WIDTH, SCREEN_HEIGHT);
-	}
-
 	ColorBuffer BackBuffers[PAGE_COUNT] = {
-		ColorBuffer(DIBBuffer[0].Surface(), SCREEN_WIDTH, SCREEN_HEIGHT),
-		ColorBuffer(DIBBuffer[1].Surface(), SCREEN_WIDTH, SCREEN_HEIGHT),
+		ColorBuffer(_Platform.GetSurface(0), SCREEN_WIDTH, SCREEN_HEIGHT),
+		ColorBuffer(_Platform.GetSurface(1), SCREEN_WIDTH, SCREEN_HEIGHT),
 	};
 	DepthBuffer DepthBuffers[PAGE_COUNT] = {
 		DepthBuffer(nullptr, SCREEN_WIDTH, SCREEN_HEIGHT),
@@ -291,11 +77,12 @@ int32 WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int32)
 		GBuffer(nullptr, SCREEN_WIDTH, SCREEN_HEIGHT),
 	};
 
+	// ここでクリアした値をレンダラーがタイルごとのクリアで使う
 	for (auto i = 0; i < PAGE_COUNT; ++i)
 	{
 		BackBuffers[i].Clear(0xFF000000);
 		DepthBuffers[i].Clear(1.0f);
-		GBuffers[i].Clear(GBufferData{ 0xFFFF });
+		GBuffers[i].Clear(GBufferData{ INVALID_TEXTURE_ID });
 	}
 
 	//--------------------------------------------------------------------------
@@ -304,43 +91,26 @@ int32 WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int32)
 	TaskSystem::Instance().Initialize();
 
 	//--------------------------------------------------------------------------
-	// メッセージループ
+	// メインループ
 	//--------------------------------------------------------------------------
-	bool IsRunning = true;
-	while (IsRunning)
+	auto FPS = 0U;
+	auto FPSPreTime = Timer.GetMicro();
+	auto FramePreTime = Timer.GetMicro();
+	while (_Platform.Update())
 	{
-		//------------------------------------------------------
-		// ウインドウメッセージ処理
-		//------------------------------------------------------
-		while (::PeekMessage(&Msg, nullptr, 0, 0, PM_REMOVE))
-		{
-			if (Msg.message == WM_QUIT)
-			{
-				IsRunning = false;
-				break;
-			}
-			::TranslateMessage(&Msg);
-			::DispatchMessage(&Msg);
-		}
-
 		//------------------------------------------------------
 		// FPS計算
 		//------------------------------------------------------
 		{
-			static auto FPS = 0U;
-			static auto PreTime = Timer.GetMicro();
 			auto NowTime = Timer.GetMicro();
-			if (NowTime - PreTime >= 1000000 / 4)
+			if (NowTime - FPSPreTime >= 1000000 / 4)
 			{
-				wchar_t Text[300];
-				swprintf_s(Text, 300, L"%s (FPS:%.1lf) (Polygon: %u/frame) (Vertex: %u/frame)",
-					APPLICATION_TITLE,
-					(fp32)FPS * 1000000.0f / (fp32)(NowTime - PreTime),
+				_Platform.ShowStatus(
+					(fp32)FPS * 1000000.0f / (fp32)(NowTime - FPSPreTime),
 					_App.GetTriangleCount(),
 					_App.GetVertexCount());
-				::SetWindowText(hWnd, Text);
 				FPS = 0;
-				PreTime = NowTime;
+				FPSPreTime = NowTime;
 			}
 			FPS++;
 		}
@@ -356,32 +126,19 @@ int32 WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int32)
 		// メイン処理
 		//------------------------------------------------------
 		{
-			// バッファを画面に転送してクリアするジョブ（必要ならBMP出力も
-			TaskSystem::Instance().PushQue([&](void* pData) {
-				::BitBlt(
-					hWindowDC, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
-					DIBBuffer[DrawPage].SurfaceDC(), 0, 0, SRCCOPY);
-				if (_RequireSaveScene)
-				{
-					_RequireSaveScene = false;
-					SaveToBMP(L"ScreenShot.bmp", BackBuffers[DrawPage]);
-				}
-				BackBuffers[DrawPage].Clear(0xFF000000);
-			}, nullptr);
-			// 深度バッファをクリアするジョブ
-			TaskSystem::Instance().PushQue([&](void* pData) {
-				DepthBuffers[DrawPage].Clear(1.0f);
-			}, nullptr);
-			// Gバッファをクリアするジョブ
-			TaskSystem::Instance().PushQue([&](void* pData) {
-				GBuffers[DrawPage].Clear(GBufferData{ 0xFFFF });
-			}, nullptr);
+			// バッファを出力するジョブ
+			// 各バッファはレンダラーが三角形のないタイルだけをクリアするので、ここではクリアしない
+			//  出力（バッチではファイルの書き出し）の時間がレンダラーのフェーズに入らないようにバリアで区切る
+			TaskSystem::Instance().SetPhaseName("Present");
+			TaskSystem::Instance().PushQue([&, DrawPage](void* pData) {
+				_Platform.Present(DrawPage, BackBuffers[DrawPage]);
+			}, nullptr, "Present");
+			TaskSystem::Instance().PushBarrier();
 
 			// フレームのdeltaを求める
-			static auto PreTime = Timer.GetMicro();
 			auto NowTime = Timer.GetMicro();
-			auto FrameTime = (fp32)(NowTime - PreTime) / 1000000.0f;
-			PreTime = NowTime;
+			auto FrameTime = (fp32)(NowTime - FramePreTime) / 1000000.0f;
+			FramePreTime = NowTime;
 
 			// フレームの更新処理
 			_App.OnUpdate(FrameTime);
@@ -390,6 +147,9 @@ int32 WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int32)
 
 		// 積まれているタスクジョブの実行
 		TaskSystem::Instance().Execute();
+
+		// 描画が完了したバッファを渡す
+		_Platform.Capture(RenderPage, BackBuffers[RenderPage], DepthBuffers[RenderPage], GBuffers[RenderPage]);
 	}
 
 	//--------------------------------------------------------------------------
@@ -397,26 +157,11 @@ int32 WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int32)
 	//--------------------------------------------------------------------------
 	TaskSystem::Instance().Finalize();
 
-	//--------------------------------------------------------------------------
-	// バックバッファ解放
-	//--------------------------------------------------------------------------
-	for (auto i = 0; i < PAGE_COUNT; ++i)
-	{
-		DIBBuffer[i].Release();
-	}
-
 	//--------------------------------------------------------------------------
 	// 解放
 	//--------------------------------------------------------------------------
 	_App.OnFinalize();
+	_Platform.Finalize();
 
 	return 0;
 }
-
-//======================================================================================================
-//
-//======================================================================================================
-int32 main()
-{
-	return WinMain(::GetModuleHandle(nullptr), nullptr, nullptr, 0);
-}
@@ -0,0 +1,375 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Framework/Framework.h>
+#include <Platform/CapturePlatform.h>
+#include <Application/Application.h>
+#include <Misc/File.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static Application _App;
+
+//======================================================================================================
+// 比較に使う視点
+//  Applicationの初期カメラと、ベンチマークと同じ傾向になる視点
+//======================================================================================================
+struct ReferenceView
+{
+	const char*	pName;
+	fp32		Distance;
+	fp32		AngleX, AngleY;
+	fp32		TargetX, TargetY, TargetZ;
+};
+
+static const ReferenceView _Views[] = {
+	{ "default",	 9.65f, -0.29f, 1.76f,  0.0f, 3.0f, 0.0f },
+	{ "near-wall",	 0.60f, -1.20f, 0.90f, -1.0f, 0.0f, 0.0f },
+	{ "grazing",	14.00f, -0.04f, 2.40f,  0.0f, 0.5f, 0.0f },
+	{ "overdraw",	40.00f, -0.15f, 0.70f,  0.0f, 3.0f, 0.0f },
+};
+static const int32 VIEW_COUNT = int32(sizeof(_Views) / sizeof(_Views[0]));
+
+//======================================================================================================
+// ゴールデンファイル
+//  'GOLD' Width Height Color[Width*Height] Depth[Width*Height] TriangleId[Width*Height]
+//======================================================================================================
+static const uint32 GOLDEN_MAGIC = 'GOLD';
+
+static bool SaveGolden(const char* pFileName, const CapturePlatform::Frame& Frame)
+{
+	File Output;
+	if (!Output.Open(pFileName, "wb"))
+	{
+		fprintf(stderr, "failed to open %s\n", pFileName);
+		return false;
+	}
+
+	const uint32 Head[3] = { GOLDEN_MAGIC, uint32(Frame.Width), uint32(Frame.Height) };
+	const uint64 PixelCount = uint64(Frame.Width) * uint64(Frame.Height);
+	Output.Write(Head, sizeof(Head));
+	Output.Write(&Frame.Colors[0], sizeof(Color) * PixelCount);
+	Output.Write(&Frame.Depths[0], sizeof(fp32) * PixelCount);
+	Output.Write(&Frame.TriangleIds[0], sizeof(uint16) * PixelCount);
+	return true;
+}
+
+static bool LoadGolden(const char* pFileName, CapturePlatform::Frame& Frame)
+{
+	File Input;
+	if (!Input.Open(pFileName, "rb"))
+	{
+		fprintf(stderr, "failed to open %s\n", pFileName);
+		return false;
+	}
+
+	uint32 Head[3];
+	if ((Input.Read(Head, sizeof(Head)) != sizeof(Head)) || (Head[0] != GOLDEN_MAGIC))
+	{
+		fprintf(stderr, "%s is not a golden file\n", pFileName);
+		return false;
+	}
+
+	Frame.Width = int32(Head[1]);
+	Frame.Height = int32(Head[2]);
+	const uint64 PixelCount = uint64(Frame.Width) * uint64(Frame.Height);
+	Frame.Colors.resize(PixelCount);
+	Frame.Depths.resize(PixelCount);
+	Frame.TriangleIds.resize(PixelCount);
+
+	const bool IsRead =
+		(Input.Read(&Frame.Colors[0], sizeof(Color) * PixelCount) == sizeof(Color) * PixelCount) &&
+		(Input.Read(&Frame.Depths[0], sizeof(fp32) * PixelCount) == sizeof(fp32) * PixelCount) &&
+		(Input.Read(&Frame.TriangleIds[0], sizeof(uint16) * PixelCount) == sizeof(uint16) * PixelCount);
+	if (!IsRead)
+	{
+		fprintf(stderr, "%s is truncated\n", pFileName);
+		return false;
+	}
+
+	return true;
+}
+
+//======================================================================================================
+// 差分の統計
+//  許容値を超えたピクセルの数と、差の最大値・平均値
+//======================================================================================================
+struct DiffStats
+{
+	int32	OverCount;
+	fp64	MaxError;
+	fp64	MeanError;
+};
+
+template <typename T, typename ErrorFunc>
+static DiffStats CompareBuffer(const std::vector<T>& Actual, const std::vector<T>& Golden, fp64 Tolerance, std::vector<bool>& OverMask, ErrorFunc GetError)
+{
+	DiffStats Stats = { 0, 0.0, 0.0 };
+	const auto PixelCount = Actual.size();
+	for (size_t i = 0; i < PixelCount; ++i)
+	{
+		const fp64 Error = GetError(Actual[i], Golden[i]);
+		Stats.MaxError = std::max(Stats.MaxError, Error);
+		Stats.MeanError += Error;
+		if (Error > Tolerance)
+		{
+			Stats.OverCount++;
+			OverMask[i] = true;
+		}
+	}
+	Stats.MeanError /= fp64(std::max<size_t>(1, PixelCount));
+	return Stats;
+}
+
+//======================================================================================================
+// 差分画像（許容値を超えたピクセルを赤、それ以外は暗くした結果）
+//======================================================================================================
+static bool SaveDiffImage(const char* pFileName, const CapturePlatform::Frame& Frame, const std::vector<bool>& OverMask)
+{
+	ColorBuffer Diff(nullptr, Frame.Width, Frame.Height);
+	auto* pPixel = Diff.GetPixelPointer();
+	for (size_t i = 0; i < OverMask.size(); ++i)
+	{
+		Color Src = Frame.Colors[i];
+		pPixel[i] = OverMask[i] ? Color(0xFFFF0000) : Color(0xFF000000 | ((Src.data >> 2) & 0x003F3F3F));
+	}
+	return SaveToBMP(pFileName, Diff);
+}
+
+//======================================================================================================
+// usage: RasterizerGolden [--scene Scene.mbin] [--update] [--diff DiffDirectory] [--occlusion] [--visibility] [--tile-shading]
+//                         [--color-tolerance 2] [--depth-tolerance 0.0001] [--max-diff 0.1] GoldenDirectory
+//  基準の視点から描画して GoldenDirectory/<視点>.gold と比較する
+//  色は各チャンネルの差、深度は差の絶対値、TriangleIdは一致しないピクセルを数えて
+//  許容値を超えたピクセルが max-diff（%）より多ければ失敗として 2 を返す
+//  --update を指定すると比較せずにゴールデンファイル（確認用の .bmp も）を書き出す
+//  --occlusion を指定するとオクルージョンカリングを有効にして描画する（結果は変わらないはず）
+//  --visibility を指定すると可視バッファで描画する（GBufferに書き込まないのでTriangleIdは比べない）
+//  --tile-shading を指定するとタイルごとにシェーディングまで行う（こちらも画面のGBufferには書き込まない）
+//======================================================================================================
+int32 main(int32 argc, char* argv[])
+{
+	const char* pSceneFileName = nullptr;
+	const char* pGoldenDirectory = nullptr;
+	const char* pDiffDirectory = nullptr;
+	bool IsUpdate = false;
+	bool IsGBufferEmpty = false;	// 画面のGBufferに書き込まない描画方法か
+	fp64 ColorTolerance = 2.0;
+	fp64 DepthTolerance = 0.0001;
+	fp64 MaxDiffPercent = 0.1;
+
+	for (int32 i = 1; i < argc; ++i)
+	{
+		const bool HasValue = (i + 1 < argc);
+		if (strcmp(argv[i], "--update") == 0)
+		{
+			IsUpdate = true;
+		}
+		else if (strcmp(argv[i], "--occlusion") == 0)
+		{
+			_App.SetOcclusionCulling(true);
+		}
+		else if (strcmp(argv[i], "--visibility") == 0)
+		{
+			_App.SetVisibilityBuffer(true);
+			IsGBufferEmpty = true;
+		}
+		else if (strcmp(argv[i], "--tile-shading") == 0)
+		{
+			_App.SetTileShading(true);
+			IsGBufferEmpty = true;
+		}
+		else if (HasValue && (strcmp(argv[i], "--scene") == 0))
+		{
+			pSceneFileName = argv[++i];
+		}
+		else if (HasValue && (strcmp(argv[i], "--diff") == 0))
+		{
+			pDiffDirectory = argv[++i];
+		}
+		else if (HasValue && (strcmp(argv[i], "--color-tolerance") == 0))
+		{
+			ColorTolerance = atof(argv[++i]);
+		}
+		else if (HasValue && (strcmp(argv[i], "--depth-tolerance") == 0))
+		{
+			DepthTolerance = atof(argv[++i]);
+		}
+		else if (HasValue && (strcmp(argv[i], "--max-diff") == 0))
+		{
+			MaxDiffPercent = atof(argv[++i]);
+		}
+		else if ((argv[i][0] != '-') && (pGoldenDirectory == nullptr))
+		{
+			pGoldenDirectory = argv[i];
+		}
+		else
+		{
+			pGoldenDirectory = nullptr;
+			break;
+		}
+	}
+
+	// 画面のGBufferに書き込まないとTriangleIdが取れないのでゴールデンファイルは作れない
+	if ((pGoldenDirectory == nullptr) || (IsUpdate && IsGBufferEmpty))
+	{
+		fprintf(stderr, "usage: %s [--scene Scene.mbin] [--update] [--diff DiffDirectory] [--occlusion] [--visibility] [--tile-shading] [--color-tolerance 2] [--depth-tolerance 0.0001] [--max-diff 0.1] GoldenDirectory\n", argv[0]);
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// 描画
+	//--------------------------------------------------------------------------
+	std::vector<CameraPose> Poses;
+	for (auto&& View : _Views)
+	{
+		CameraPose Pose = {};
+		Pose.bMatrix = false;
+		Pose.Distance = View.Distance;
+		Vector_Set(Pose.Angle, View.AngleX, View.AngleY, 0.0f, 0.0f);
+		Vector_Set(Pose.Target, View.TargetX, View.TargetY, View.TargetZ, 1.0f);
+		Poses.push_back(Pose);
+	}
+
+	if (pSceneFileName != nullptr)
+	{
+		_App.SetSceneFileName(pSceneFileName);
+	}
+
+	// 深度も比べるので、タイルごとにシェーディングするときも画面に書き出す
+	_App.SetDepthOutput(true);
+
+	CapturePlatform Platform(Poses);
+	Framework Framework(Platform, _App);
+	if (Framework.Run() != 0)
+	{
+		fprintf(stderr, "failed to load scene\n");
+		return 1;
+	}
+
+	const auto& Frames = Platform.GetFrames();
+	if (int32(Frames.size()) != VIEW_COUNT)
+	{
+		fprintf(stderr, "capture is not available\n");
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// ゴールデンファイルの更新
+	//--------------------------------------------------------------------------
+	char FileName[1024];
+	if (IsUpdate)
+	{
+		for (int32 i = 0; i < VIEW_COUNT; ++i)
+		{
+			snprintf(FileName, sizeof(FileName), "%s/%s.gold", pGoldenDirectory, _Views[i].pName);
+			if (!SaveGolden(FileName, Frames[i])) return 1;
+
+			snprintf(FileName, sizeof(FileName), "%s/%s.bmp", pGoldenDirectory, _Views[i].pName);
+			ColorBuffer Buffer(const_cast<Color*>(&Frames[i].Colors[0]), Frames[i].Width, Frames[i].Height);
+			if (!SaveToBMP(FileName, Buffer)) return 1;
+
+			printf("%-10s updated\n", _Views[i].pName);
+		}
+		return 0;
+	}
+
+	//--------------------------------------------------------------------------
+	// 比較
+	//--------------------------------------------------------------------------
+	auto ColorError = [](Color a, Color b) {
+		const int32 db = std::abs(int32(a.b) - int32(b.b));
+		const int32 dg = std::abs(int32(a.g) - int32(b.g));
+		const int32 dr = std::abs(int32(a.r) - int32(b.r));
+		const int32 da = std::abs(int32(a.a) - int32(b.a));
+		return fp64(std::max(std::max(db, dg), std::max(dr, da)));
+	};
+	auto DepthError = [](fp32 a, fp32 b) {
+		return fp64(std::fabs(a - b));
+	};
+	auto IdError = [](uint16 a, uint16 b) {
+		return (a != b) ? 1.0 : 0.0;
+	};
+
+	int32 FailCount = 0;
+	printf("%-10s %-10s %10s %10s %12s %12s\n", "view", "buffer", "over", "over(%)", "max", "mean");
+	for (int32 i = 0; i < VIEW_COUNT; ++i)
+	{
+		const auto& Actual = Frames[i];
+
+		CapturePlatform::Frame Golden;
+		snprintf(FileName, sizeof(FileName), "%s/%s.gold", pGoldenDirectory, _Views[i].pName);
+		if (!LoadGolden(FileName, Golden))
+		{
+			FailCount++;
+			continue;
+		}
+		if ((Golden.Width != Actual.Width) || (Golden.Height != Actual.Height))
+		{
+			fprintf(stderr, "%s: size mismatch %dx%d (golden %dx%d)\n", _Views[i].pName, Actual.Width, Actual.Height, Golden.Width, Golden.Height);
+			FailCount++;
+			continue;
+		}
+
+		const int32 PixelCount = Actual.Width * Actual.Height;
+		std::vector<bool> OverMask(PixelCount, false);
+		const int32 BufferCount = IsGBufferEmpty ? 2 : 3;
+		DiffStats Stats[3] = {
+			CompareBuffer(Actual.Colors, Golden.Colors, ColorTolerance, OverMask, ColorError),
+			CompareBuffer(Actual.Depths, Golden.Depths, DepthTolerance, OverMask, DepthError),
+		};
+		if (BufferCount > 2)
+		{
+			Stats[2] = CompareBuffer(Actual.TriangleIds, Golden.TriangleIds, 0.0, OverMask, IdError);
+		}
+		static const char* BufferNames[] = { "Color", "Depth", "TriangleId" };
+
+		bool IsFailed = false;
+		for (int32 b = 0; b < BufferCount; ++b)
+		{
+			const auto OverPercent = fp64(Stats[b].OverCount) * 100.0 / fp64(PixelCount);
+			const bool IsOver = OverPercent > MaxDiffPercent;
+			printf("%-10s %-10s %10d %10.4f %12.6f %12.6f%s\n",
+				_Views[i].pName, BufferNames[b],
+				Stats[b].OverCount, OverPercent,
+				Stats[b].MaxError, Stats[b].MeanError,
+				IsOver ? "  FAILED" : "");
+			IsFailed |= IsOver;
+		}
+
+		if (IsFailed)
+		{
+			FailCount++;
+		}
+
+		if (pDiffDirectory != nullptr)
+		{
+			snprintf(FileName, sizeof(FileName), "%s/%s_diff.bmp", pDiffDirectory, _Views[i].pName);
+			if (!SaveDiffImage(FileName, Actual, OverMask))
+			{
+				fprintf(stderr, "failed to write %s\n", FileName);
+			}
+		}
+	}
+
+	if (FailCount > 0)
+	{
+		printf("%d of %d views differ from %s\n", FailCount, VIEW_COUNT, pGoldenDirectory);
+		return 2;
+	}
+	printf("all %d views match %s\n", VIEW_COUNT, pGoldenDirectory);
+	return 0;
+}
@@ -0,0 +1,59 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Framework/Framework.h>
+#include <Platform/HeadlessPlatform.h>
+#include <Application/Application.h>
+#include <TaskSystem/TaskSystem.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static Application _App;
+
+//======================================================================================================
+// usage: RasterizerHeadless [--trace Trace.json] [FrameCount] [Output.bmp]
+//  カレントディレクトリの resources/ からシーンを読み込んで FrameCount フレーム描画する
+//  Output.bmp を指定すると最後のフレームを書き出す
+//  --trace を指定すると全フレームのジョブの実行記録を Chrome trace 形式で書き出す
+//======================================================================================================
+int32 main(int32 argc, char* argv[])
+{
+	const char* pTraceFileName = nullptr;
+	std::vector<const char*> Args;
+	for (int32 i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+		{
+			pTraceFileName = argv[++i];
+		}
+		else
+		{
+			Args.push_back(argv[i]);
+		}
+	}
+
+	const int32 FrameCount = (Args.size() > 0) ? std::max(1, atoi(Args[0])) : 100;
+	const char* pOutputFileName = (Args.size() > 1) ? Args[1] : nullptr;
+
+	if (pTraceFileName != nullptr)
+	{
+		// 最後のバッファを出力するための1回を含める
+		TaskSystem::Instance().BeginTrace(pTraceFileName, FrameCount + 1);
+	}
+
+	HeadlessPlatform Platform(FrameCount, pOutputFileName);
+	Framework Framework(Platform, _App);
+	return Framework.Run();
+}
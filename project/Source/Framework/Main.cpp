@@ -0,0 +1,60 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Framework/Framework.h>
+#include <Platform/Win32Platform.h>
+#include <Application/Application.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static Application _App;
+
+//======================================================================================================
+//
+//======================================================================================================
+int32 WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int32)
+{
+	wchar_t ModuleFileName[MAX_PATH];
+
+	//---------------------------------------------------------
+	// カレントディレクトリ設定
+	//---------------------------------------------------------
+	GetModuleFileName(hInstance, ModuleFileName, MAX_PATH);
+	auto Length = (int32)wcslen(ModuleFileName);
+	while (ModuleFileName[Length] != L'\\')
+	{
+		if (--Length < 0)
+		{
+			break;
+		}
+	}
+	ModuleFileName[Length + 1] = L'\0';
+	SetCurrentDirectory(ModuleFileName);
+
+	//---------------------------------------------------------
+	// ウィンドウに表示しながら実行
+	//---------------------------------------------------------
+	Win32Platform Platform(hInstance);
+	Framework Framework(Platform, _App);
+	return Framework.Run();
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+int32 main()
+{
+	return WinMain(::GetModuleHandle(nullptr), nullptr, nullptr, 0);
+}
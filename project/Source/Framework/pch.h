@@ -23,16 +23,26 @@
 //======================================================================================================
 //
 //======================================================================================================
+#if defined(_WIN32)
 #include <windows.h>
+#endif//defined(_WIN32)
 #include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
 #include <map>
 #include <mutex>
+#include <thread>
 #include <string>
 #include <atomic>
 #include <chrono>
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <condition_variable>
 
 //======================================================================================================
 //
@@ -65,14 +75,28 @@ static const int32		SCREEN_HEIGHT_HALF		= SCREEN_HEIGHT / 2;
 static const fp32		SCREEN_WIDTH_HALF_F		= fp32(SCREEN_WIDTH_HALF);
 static const fp32		SCREEN_HEIGHT_HALF_F	= fp32(SCREEN_HEIGHT_HALF);
 
-static const int32		MAX_TILE_TRIANGLE_COUNT	= 10 * 10000;
+// 辺の式を28.4の固定小数点でint32に収めるため、ガードバンドは画面の2倍までにする
+static const fp32		GUARD_BAND_SCALE		= 2.0f;
+
+static const int32		RASTERIZE_CHUNK_SIZE	= 256;
+static const int32		RASTERIZE_SETUP_BLOCK	= 256;
+static const int32		RASTERIZE_BLOCK_SIZE	= 8;
+static const uint64		RASTERIZE_ARENA_BLOCK	= 4ULL << 20;
+static const uint64		MAX_RASTERIZE_ARENA		= 1ULL << 30;
 static const int32		MAX_VERTEX_CACHE_SIZE	= 0x0000FFFF;
+static const int32		OCCLUSION_BUFFER_SCALE	= 4;
+static const int32		MESH_CLUSTER_VERTEX_COUNT	= 64;
+static const int32		MESH_CLUSTER_TRIANGLE_COUNT	= 124;
+static const int32		GEOMETRY_BATCH_VERTEX_COUNT		= 1024;
+static const int32		GEOMETRY_BATCH_TRIANGLE_COUNT	= 512;
 
 static const int32		BUFFER_TILE_SIZE_X		= SCREEN_WIDTH  / 20;
 static const int32		BUFFER_TILE_SIZE_Y		= SCREEN_HEIGHT / 20;
 
 static const int32		MAX_TILE_COUNT_X		= (SCREEN_WIDTH  + (BUFFER_TILE_SIZE_X - 1)) / BUFFER_TILE_SIZE_X;
 static const int32		MAX_TILE_COUNT_Y		= (SCREEN_HEIGHT + (BUFFER_TILE_SIZE_Y - 1)) / BUFFER_TILE_SIZE_Y;
+static const int32		TILE_BLOCK_COUNT_X		= (BUFFER_TILE_SIZE_X + (RASTERIZE_BLOCK_SIZE - 1)) / RASTERIZE_BLOCK_SIZE;
+static const int32		TILE_BLOCK_COUNT_Y		= (BUFFER_TILE_SIZE_Y + (RASTERIZE_BLOCK_SIZE - 1)) / RASTERIZE_BLOCK_SIZE;
 
 //======================================================================================================
 //
@@ -13,6 +13,7 @@
 //
 //======================================================================================================
 #include <Math/Math.h>
+#include <Math/SIMD.h>
 
 //======================================================================================================
 //
@@ -1008,3 +1009,173 @@ void Matrix_Transform4x4Projection(Vector4& Result, const Vector3 lhs, const Mat
 	Result.y *= InvW;
 	Result.z *= InvW;
 }
+
+//======================================================================================================
+// SIMD_WIDTH個までの頂点をSoAに並べ替えて読み込む（足りない分は0にする）
+//======================================================================================================
+static void LoadBatch(fp32x8& x, fp32x8& y, fp32x8& z, const Vector3 Input[], const uint16* pIndex, int32 Offset, int32 Count)
+{
+	// 連続した8個ならまとめて読んでから分ける
+	if ((pIndex == nullptr) && (Count == SIMD_WIDTH))
+	{
+		SIMD_LoadDeinterleave3(&Input[Offset].x, x, y, z);
+		return;
+	}
+
+	fp32 sx[SIMD_WIDTH] = {}, sy[SIMD_WIDTH] = {}, sz[SIMD_WIDTH] = {};
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const auto& v = Input[(pIndex != nullptr) ? pIndex[Offset + i] : (Offset + i)];
+		sx[i] = v.x;
+		sy[i] = v.y;
+		sz[i] = v.z;
+	}
+	x = SIMD_Load(sx);
+	y = SIMD_Load(sy);
+	z = SIMD_Load(sz);
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+static void LoadBatch(fp32x8& x, fp32x8& y, fp32x8& z, const fp32* pInputX, const fp32* pInputY, const fp32* pInputZ, const uint16* pIndex, int32 Offset, int32 Count)
+{
+	// 連続した8個ならそのまま読める
+	if ((pIndex == nullptr) && (Count == SIMD_WIDTH))
+	{
+		x = SIMD_Load(pInputX + Offset);
+		y = SIMD_Load(pInputY + Offset);
+		z = SIMD_Load(pInputZ + Offset);
+		return;
+	}
+
+	fp32 sx[SIMD_WIDTH] = {}, sy[SIMD_WIDTH] = {}, sz[SIMD_WIDTH] = {};
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const auto v = (pIndex != nullptr) ? pIndex[Offset + i] : (Offset + i);
+		sx[i] = pInputX[v];
+		sy[i] = pInputY[v];
+		sz[i] = pInputZ[v];
+	}
+	x = SIMD_Load(sx);
+	y = SIMD_Load(sy);
+	z = SIMD_Load(sz);
+}
+
+//======================================================================================================
+// Loadで読んだSIMD_WIDTH個ずつの頂点に3x3の行列を掛ける
+//======================================================================================================
+template <typename LoadFunc>
+static void Transform3x3Batch(Vector3 Result[], int32 Count, const Matrix& rhs, LoadFunc Load)
+{
+	const auto xx = SIMD_Set(rhs.x.x), xy = SIMD_Set(rhs.x.y), xz = SIMD_Set(rhs.x.z);
+	const auto yx = SIMD_Set(rhs.y.x), yy = SIMD_Set(rhs.y.y), yz = SIMD_Set(rhs.y.z);
+	const auto zx = SIMD_Set(rhs.z.x), zy = SIMD_Set(rhs.z.y), zz = SIMD_Set(rhs.z.z);
+
+	for (int32 i = 0; i < Count; i += SIMD_WIDTH)
+	{
+		const auto n = std::min(SIMD_WIDTH, Count - i);
+
+		fp32x8 x, y, z;
+		Load(x, y, z, i, n);
+
+		const auto rx = SIMD_MulAdd(z, zx, SIMD_Add(SIMD_Mul(y, yx), SIMD_Mul(x, xx)));
+		const auto ry = SIMD_MulAdd(z, zy, SIMD_Add(SIMD_Mul(y, yy), SIMD_Mul(x, xy)));
+		const auto rz = SIMD_MulAdd(z, zz, SIMD_Add(SIMD_Mul(y, yz), SIMD_Mul(x, xz)));
+
+		// Vector3はfp32が3つ並んでいるので、AoSに戻しながらそのまま書き込める
+		if (n == SIMD_WIDTH)
+		{
+			SIMD_StoreInterleave3(&Result[i].x, rx, ry, rz);
+		}
+		else
+		{
+			Vector3 Temp[SIMD_WIDTH];
+			SIMD_StoreInterleave3(&Temp[0].x, rx, ry, rz);
+			for (int32 j = 0; j < n; ++j)
+			{
+				Result[i + j] = Temp[j];
+			}
+		}
+	}
+}
+
+//======================================================================================================
+// Loadで読んだSIMD_WIDTH個ずつの頂点（w=1）に4x4の行列を掛ける
+//======================================================================================================
+template <typename LoadFunc>
+static void Transform4x4Batch(Vector4 Result[], int32 Count, const Matrix& rhs, LoadFunc Load)
+{
+	const auto xx = SIMD_Set(rhs.x.x), xy = SIMD_Set(rhs.x.y), xz = SIMD_Set(rhs.x.z), xw = SIMD_Set(rhs.x.w);
+	const auto yx = SIMD_Set(rhs.y.x), yy = SIMD_Set(rhs.y.y), yz = SIMD_Set(rhs.y.z), yw = SIMD_Set(rhs.y.w);
+	const auto zx = SIMD_Set(rhs.z.x), zy = SIMD_Set(rhs.z.y), zz = SIMD_Set(rhs.z.z), zw = SIMD_Set(rhs.z.w);
+	const auto wx = SIMD_Set(rhs.w.x), wy = SIMD_Set(rhs.w.y), wz = SIMD_Set(rhs.w.z), ww = SIMD_Set(rhs.w.w);
+
+	for (int32 i = 0; i < Count; i += SIMD_WIDTH)
+	{
+		const auto n = std::min(SIMD_WIDTH, Count - i);
+
+		fp32x8 x, y, z;
+		Load(x, y, z, i, n);
+
+		const auto rx = SIMD_Add(SIMD_MulAdd(z, zx, SIMD_Add(SIMD_Mul(y, yx), SIMD_Mul(x, xx))), wx);
+		const auto ry = SIMD_Add(SIMD_MulAdd(z, zy, SIMD_Add(SIMD_Mul(y, yy), SIMD_Mul(x, xy))), wy);
+		const auto rz = SIMD_Add(SIMD_MulAdd(z, zz, SIMD_Add(SIMD_Mul(y, yz), SIMD_Mul(x, xz))), wz);
+		const auto rw = SIMD_Add(SIMD_MulAdd(z, zw, SIMD_Add(SIMD_Mul(y, yw), SIMD_Mul(x, xw))), ww);
+
+		// Vector4はfp32が4つ並んでいるので、AoSに戻しながらそのまま書き込める
+		if (n == SIMD_WIDTH)
+		{
+			SIMD_StoreInterleave4(&Result[i].x, rx, ry, rz, rw);
+		}
+		else
+		{
+			Vector4 Temp[SIMD_WIDTH];
+			SIMD_StoreInterleave4(&Temp[0].x, rx, ry, rz, rw);
+			for (int32 j = 0; j < n; ++j)
+			{
+				Result[i + j] = Temp[j];
+			}
+		}
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void Matrix_Transform3x3Batch(Vector3 Result[], const Vector3 Input[], const uint16* pIndex, int32 Count, const Matrix& rhs)
+{
+	Transform3x3Batch(Result, Count, rhs, [&](fp32x8& x, fp32x8& y, fp32x8& z, int32 Offset, int32 n) {
+		LoadBatch(x, y, z, Input, pIndex, Offset, n);
+	});
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void Matrix_Transform3x3Batch(Vector3 Result[], const fp32* pInputX, const fp32* pInputY, const fp32* pInputZ, const uint16* pIndex, int32 Count, const Matrix& rhs)
+{
+	Transform3x3Batch(Result, Count, rhs, [&](fp32x8& x, fp32x8& y, fp32x8& z, int32 Offset, int32 n) {
+		LoadBatch(x, y, z, pInputX, pInputY, pInputZ, pIndex, Offset, n);
+	});
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void Matrix_Transform4x4Batch(Vector4 Result[], const Vector3 Input[], const uint16* pIndex, int32 Count, const Matrix& rhs)
+{
+	Transform4x4Batch(Result, Count, rhs, [&](fp32x8& x, fp32x8& y, fp32x8& z, int32 Offset, int32 n) {
+		LoadBatch(x, y, z, Input, pIndex, Offset, n);
+	});
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void Matrix_Transform4x4Batch(Vector4 Result[], const fp32* pInputX, const fp32* pInputY, const fp32* pInputZ, const uint16* pIndex, int32 Count, const Matrix& rhs)
+{
+	Transform4x4Batch(Result, Count, rhs, [&](fp32x8& x, fp32x8& y, fp32x8& z, int32 Offset, int32 n) {
+		LoadBatch(x, y, z, pInputX, pInputY, pInputZ, pIndex, Offset, n);
+	});
+}
@@ -168,3 +168,10 @@ void Matrix_Transform4x4(Vector4& Result, const Vector4 lhs, const Matrix& rhs);
 void Matrix_Transform4x4(Vector4& Result, const Vector3 lhs, const Matrix& rhs);
 void Matrix_Transform4x4Projection(Vector4& Result, const Vector4 lhs, const Matrix& rhs);
 void Matrix_Transform4x4Projection(Vector4& Result, const Vector3 lhs, const Matrix& rhs);
+
+// Count個の頂点をSIMDでまとめて変換する（pIndexがnullptrでなければInput[pIndex[i]]を変換してResult[i]に書き込む）
+//  入力はVector3の配列か、x,y,zを別々の配列に並べたSoAのどちらでもよい
+void Matrix_Transform3x3Batch(Vector3 Result[], const Vector3 Input[], const uint16* pIndex, int32 Count, const Matrix& rhs);
+void Matrix_Transform3x3Batch(Vector3 Result[], const fp32* pInputX, const fp32* pInputY, const fp32* pInputZ, const uint16* pIndex, int32 Count, const Matrix& rhs);
+void Matrix_Transform4x4Batch(Vector4 Result[], const Vector3 Input[], const uint16* pIndex, int32 Count, const Matrix& rhs);
+void Matrix_Transform4x4Batch(Vector4 Result[], const fp32* pInputX, const fp32* pInputY, const fp32* pInputZ, const uint16* pIndex, int32 Count, const Matrix& rhs);
@@ -0,0 +1,298 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#pragma once
+
+//======================================================================================================
+// 8要素のfp32（とint32）をまとめて処理するための型
+//  AVX2が使えれば__m256、SSE2なら__m128を2つ、どちらもなければ配列で同じ処理をする
+//  SIMD_DISABLEを定義すると常に配列で処理する（結果の比較用）
+//======================================================================================================
+#if defined(SIMD_DISABLE)
+#elif defined(__AVX2__)
+#define SIMD_USE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SIMD_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+static const int32 SIMD_WIDTH = 8;
+
+//======================================================================================================
+//
+//======================================================================================================
+#if defined(SIMD_USE_AVX2)
+
+struct fp32x8
+{
+	__m256	v;
+};
+
+struct int32x8
+{
+	__m256i	v;
+};
+
+inline fp32x8 SIMD_Set(fp32 a) { return fp32x8{ _mm256_set1_ps(a) }; }
+inline fp32x8 SIMD_Ramp() { return fp32x8{ _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f) }; }
+inline fp32x8 SIMD_Load(const fp32* p) { return fp32x8{ _mm256_loadu_ps(p) }; }
+inline void SIMD_Store(fp32* p, fp32x8 a) { _mm256_storeu_ps(p, a.v); }
+inline fp32x8 SIMD_Add(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_add_ps(a.v, b.v) }; }
+inline fp32x8 SIMD_Sub(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_sub_ps(a.v, b.v) }; }
+inline fp32x8 SIMD_Mul(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_mul_ps(a.v, b.v) }; }
+inline fp32x8 SIMD_Div(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_div_ps(a.v, b.v) }; }
+inline fp32x8 SIMD_Min(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_min_ps(a.v, b.v) }; }
+inline fp32x8 SIMD_Max(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_max_ps(a.v, b.v) }; }
+inline fp32x8 SIMD_CmpGE(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline fp32x8 SIMD_CmpLE(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline fp32x8 SIMD_CmpLT(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline fp32x8 SIMD_And(fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_and_ps(a.v, b.v) }; }
+inline fp32x8 SIMD_Select(fp32x8 Mask, fp32x8 a, fp32x8 b) { return fp32x8{ _mm256_blendv_ps(b.v, a.v, Mask.v) }; }
+inline int32 SIMD_MoveMask(fp32x8 Mask) { return _mm256_movemask_ps(Mask.v); }
+
+inline int32x8 SIMD_SetInt(int32 a) { return int32x8{ _mm256_set1_epi32(a) }; }
+inline int32x8 SIMD_RampInt(int32 Step) { return int32x8{ _mm256_setr_epi32(0, Step, Step * 2, Step * 3, Step * 4, Step * 5, Step * 6, Step * 7) }; }
+inline int32x8 SIMD_AddInt(int32x8 a, int32x8 b) { return int32x8{ _mm256_add_epi32(a.v, b.v) }; }
+inline fp32x8 SIMD_CmpGTInt(int32x8 a, int32x8 b) { return fp32x8{ _mm256_castsi256_ps(_mm256_cmpgt_epi32(a.v, b.v)) }; }
+inline void SIMD_StoreInt(int32* p, int32x8 a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a.v); }
+
+// SIMD_FloorとSIMD_ToIntはint32に収まる値だけを扱う（SIMD_ToIntは一番近い整数に丸める）
+inline fp32x8 SIMD_Abs(fp32x8 a) { return fp32x8{ _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+inline fp32x8 SIMD_Floor(fp32x8 a) { return fp32x8{ _mm256_floor_ps(a.v) }; }
+inline int32x8 SIMD_ToInt(fp32x8 a) { return int32x8{ _mm256_cvtps_epi32(a.v) }; }
+
+// a,b,c,dの8要素を(a[i], b[i], c[i], d[i])の順に並べて32個書き込む
+inline void SIMD_StoreInterleave4(fp32* p, fp32x8 a, fp32x8 b, fp32x8 c, fp32x8 d)
+{
+	const auto ab0 = _mm256_unpacklo_ps(a.v, b.v);
+	const auto ab1 = _mm256_unpackhi_ps(a.v, b.v);
+	const auto cd0 = _mm256_unpacklo_ps(c.v, d.v);
+	const auto cd1 = _mm256_unpackhi_ps(c.v, d.v);
+	const auto v04 = _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(1, 0, 1, 0));
+	const auto v15 = _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(3, 2, 3, 2));
+	const auto v26 = _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(1, 0, 1, 0));
+	const auto v37 = _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(3, 2, 3, 2));
+	_mm256_storeu_ps(p +  0, _mm256_permute2f128_ps(v04, v15, 0x20));
+	_mm256_storeu_ps(p +  8, _mm256_permute2f128_ps(v26, v37, 0x20));
+	_mm256_storeu_ps(p + 16, _mm256_permute2f128_ps(v04, v15, 0x31));
+	_mm256_storeu_ps(p + 24, _mm256_permute2f128_ps(v26, v37, 0x31));
+}
+
+// (a[i], b[i], c[i])の順に並んだ24個を読み込んでa,b,cに分ける
+inline void SIMD_LoadDeinterleave3(const fp32* p, fp32x8& a, fp32x8& b, fp32x8& c)
+{
+	auto m03 = _mm256_castps128_ps256(_mm_loadu_ps(p + 0));
+	auto m14 = _mm256_castps128_ps256(_mm_loadu_ps(p + 4));
+	auto m25 = _mm256_castps128_ps256(_mm_loadu_ps(p + 8));
+	m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(p + 12), 1);
+	m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(p + 16), 1);
+	m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(p + 20), 1);
+	const auto ab = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+	const auto bc = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+	a.v = _mm256_shuffle_ps(m03, ab, _MM_SHUFFLE(2, 0, 3, 0));
+	b.v = _mm256_shuffle_ps(bc, ab, _MM_SHUFFLE(3, 1, 2, 0));
+	c.v = _mm256_shuffle_ps(bc, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+// a,b,cの8要素を(a[i], b[i], c[i])の順に並べて24個書き込む
+inline void SIMD_StoreInterleave3(fp32* p, fp32x8 a, fp32x8 b, fp32x8 c)
+{
+	const auto ab = _mm256_shuffle_ps(a.v, b.v, _MM_SHUFFLE(2, 0, 2, 0));
+	const auto bc = _mm256_shuffle_ps(b.v, c.v, _MM_SHUFFLE(3, 1, 3, 1));
+	const auto ca = _mm256_shuffle_ps(c.v, a.v, _MM_SHUFFLE(3, 1, 2, 0));
+	const auto m03 = _mm256_shuffle_ps(ab, ca, _MM_SHUFFLE(2, 0, 2, 0));
+	const auto m14 = _mm256_shuffle_ps(bc, ab, _MM_SHUFFLE(3, 1, 2, 0));
+	const auto m25 = _mm256_shuffle_ps(ca, bc, _MM_SHUFFLE(3, 1, 3, 1));
+	_mm256_storeu_ps(p +  0, _mm256_permute2f128_ps(m03, m14, 0x20));
+	_mm256_storeu_ps(p +  8, _mm256_permute2f128_ps(m25, m03, 0x30));
+	_mm256_storeu_ps(p + 16, _mm256_permute2f128_ps(m14, m25, 0x31));
+}
+
+#elif defined(SIMD_USE_SSE2)
+
+struct fp32x8
+{
+	__m128	lo;
+	__m128	hi;
+};
+
+struct int32x8
+{
+	__m128i	lo;
+	__m128i	hi;
+};
+
+inline fp32x8 SIMD_Set(fp32 a) { return fp32x8{ _mm_set1_ps(a), _mm_set1_ps(a) }; }
+inline fp32x8 SIMD_Ramp() { return fp32x8{ _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f) }; }
+inline fp32x8 SIMD_Load(const fp32* p) { return fp32x8{ _mm_loadu_ps(p), _mm_loadu_ps(p + 4) }; }
+inline void SIMD_Store(fp32* p, fp32x8 a) { _mm_storeu_ps(p, a.lo); _mm_storeu_ps(p + 4, a.hi); }
+inline fp32x8 SIMD_Add(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_Sub(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_Mul(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_Div(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_div_ps(a.lo, b.lo), _mm_div_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_Min(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_min_ps(a.lo, b.lo), _mm_min_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_Max(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_CmpGE(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_cmpge_ps(a.lo, b.lo), _mm_cmpge_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_CmpLE(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_cmple_ps(a.lo, b.lo), _mm_cmple_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_CmpLT(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_cmplt_ps(a.lo, b.lo), _mm_cmplt_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_And(fp32x8 a, fp32x8 b) { return fp32x8{ _mm_and_ps(a.lo, b.lo), _mm_and_ps(a.hi, b.hi) }; }
+inline fp32x8 SIMD_Select(fp32x8 Mask, fp32x8 a, fp32x8 b)
+{
+	return fp32x8{
+		_mm_or_ps(_mm_and_ps(Mask.lo, a.lo), _mm_andnot_ps(Mask.lo, b.lo)),
+		_mm_or_ps(_mm_and_ps(Mask.hi, a.hi), _mm_andnot_ps(Mask.hi, b.hi)),
+	};
+}
+inline int32 SIMD_MoveMask(fp32x8 Mask) { return _mm_movemask_ps(Mask.lo) | (_mm_movemask_ps(Mask.hi) << 4); }
+
+inline int32x8 SIMD_SetInt(int32 a) { return int32x8{ _mm_set1_epi32(a), _mm_set1_epi32(a) }; }
+inline int32x8 SIMD_RampInt(int32 Step) { return int32x8{ _mm_setr_epi32(0, Step, Step * 2, Step * 3), _mm_setr_epi32(Step * 4, Step * 5, Step * 6, Step * 7) }; }
+inline int32x8 SIMD_AddInt(int32x8 a, int32x8 b) { return int32x8{ _mm_add_epi32(a.lo, b.lo), _mm_add_epi32(a.hi, b.hi) }; }
+inline fp32x8 SIMD_CmpGTInt(int32x8 a, int32x8 b) { return fp32x8{ _mm_castsi128_ps(_mm_cmpgt_epi32(a.lo, b.lo)), _mm_castsi128_ps(_mm_cmpgt_epi32(a.hi, b.hi)) }; }
+inline void SIMD_StoreInt(int32* p, int32x8 a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.lo); _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 4), a.hi); }
+
+inline fp32x8 SIMD_Abs(fp32x8 a) { return fp32x8{ _mm_andnot_ps(_mm_set1_ps(-0.0f), a.lo), _mm_andnot_ps(_mm_set1_ps(-0.0f), a.hi) }; }
+inline int32x8 SIMD_ToInt(fp32x8 a) { return int32x8{ _mm_cvtps_epi32(a.lo), _mm_cvtps_epi32(a.hi) }; }
+
+// SSE2には切り捨ての命令がないので、0方向に切り捨てて元の値より大きくなったら1引く
+inline fp32x8 SIMD_Floor(fp32x8 a)
+{
+	const auto One = _mm_set1_ps(1.0f);
+	const auto lo = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.lo));
+	const auto hi = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.hi));
+	return fp32x8{
+		_mm_sub_ps(lo, _mm_and_ps(_mm_cmpgt_ps(lo, a.lo), One)),
+		_mm_sub_ps(hi, _mm_and_ps(_mm_cmpgt_ps(hi, a.hi), One)),
+	};
+}
+
+// a,b,c,dの8要素を(a[i], b[i], c[i], d[i])の順に並べて32個書き込む
+inline void SIMD_StoreInterleave4(fp32* p, fp32x8 a, fp32x8 b, fp32x8 c, fp32x8 d)
+{
+	_MM_TRANSPOSE4_PS(a.lo, b.lo, c.lo, d.lo);
+	_MM_TRANSPOSE4_PS(a.hi, b.hi, c.hi, d.hi);
+	_mm_storeu_ps(p +  0, a.lo);
+	_mm_storeu_ps(p +  4, b.lo);
+	_mm_storeu_ps(p +  8, c.lo);
+	_mm_storeu_ps(p + 12, d.lo);
+	_mm_storeu_ps(p + 16, a.hi);
+	_mm_storeu_ps(p + 20, b.hi);
+	_mm_storeu_ps(p + 24, c.hi);
+	_mm_storeu_ps(p + 28, d.hi);
+}
+
+// SSE2では並べ替えの命令が少ないので1要素ずつ詰め替える
+inline void SIMD_LoadDeinterleave3(const fp32* p, fp32x8& a, fp32x8& b, fp32x8& c)
+{
+	a = fp32x8{ _mm_setr_ps(p[0], p[3], p[6], p[ 9]), _mm_setr_ps(p[12], p[15], p[18], p[21]) };
+	b = fp32x8{ _mm_setr_ps(p[1], p[4], p[7], p[10]), _mm_setr_ps(p[13], p[16], p[19], p[22]) };
+	c = fp32x8{ _mm_setr_ps(p[2], p[5], p[8], p[11]), _mm_setr_ps(p[14], p[17], p[20], p[23]) };
+}
+inline void SIMD_StoreInterleave3(fp32* p, fp32x8 a, fp32x8 b, fp32x8 c)
+{
+	fp32 va[8], vb[8], vc[8];
+	SIMD_Store(va, a);
+	SIMD_Store(vb, b);
+	SIMD_Store(vc, c);
+	for (int32 i = 0; i < 8; ++i) { p[i * 3 + 0] = va[i]; p[i * 3 + 1] = vb[i]; p[i * 3 + 2] = vc[i]; }
+}
+
+#else//defined(SIMD_USE_AVX2)
+
+struct fp32x8
+{
+	fp32	v[8];
+};
+
+struct int32x8
+{
+	int32	v[8];
+};
+
+// 比較結果は全ビット1か0の値で表す
+inline fp32 SIMD_MaskValue(bool b) { uint32 Bits = b ? 0xFFFFFFFF : 0; fp32 f; memcpy(&f, &Bits, sizeof(f)); return f; }
+inline bool SIMD_IsMaskOn(fp32 f) { uint32 Bits; memcpy(&Bits, &f, sizeof(f)); return (Bits & 0x80000000) != 0; }
+
+#define SIMD_SCALAR_OP(Expr)	fp32x8 r; for (int32 i = 0; i < 8; ++i) { r.v[i] = (Expr); } return r
+
+inline fp32x8 SIMD_Set(fp32 a) { SIMD_SCALAR_OP(a); }
+inline fp32x8 SIMD_Ramp() { SIMD_SCALAR_OP(fp32(i)); }
+inline fp32x8 SIMD_Load(const fp32* p) { SIMD_SCALAR_OP(p[i]); }
+inline void SIMD_Store(fp32* p, fp32x8 a) { for (int32 i = 0; i < 8; ++i) { p[i] = a.v[i]; } }
+inline fp32x8 SIMD_Add(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(a.v[i] + b.v[i]); }
+inline fp32x8 SIMD_Sub(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(a.v[i] - b.v[i]); }
+inline fp32x8 SIMD_Mul(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(a.v[i] * b.v[i]); }
+inline fp32x8 SIMD_Div(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(a.v[i] / b.v[i]); }
+inline fp32x8 SIMD_Min(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline fp32x8 SIMD_Max(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+inline fp32x8 SIMD_CmpGE(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(SIMD_MaskValue(a.v[i] >= b.v[i])); }
+inline fp32x8 SIMD_CmpLE(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(SIMD_MaskValue(a.v[i] <= b.v[i])); }
+inline fp32x8 SIMD_CmpLT(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(SIMD_MaskValue(a.v[i] < b.v[i])); }
+inline fp32x8 SIMD_And(fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(SIMD_MaskValue(SIMD_IsMaskOn(a.v[i]) && SIMD_IsMaskOn(b.v[i]))); }
+inline fp32x8 SIMD_Select(fp32x8 Mask, fp32x8 a, fp32x8 b) { SIMD_SCALAR_OP(SIMD_IsMaskOn(Mask.v[i]) ? a.v[i] : b.v[i]); }
+inline int32 SIMD_MoveMask(fp32x8 Mask) { int32 r = 0; for (int32 i = 0; i < 8; ++i) { r |= SIMD_IsMaskOn(Mask.v[i]) ? (1 << i) : 0; } return r; }
+inline void SIMD_StoreInterleave4(fp32* p, fp32x8 a, fp32x8 b, fp32x8 c, fp32x8 d) { for (int32 i = 0; i < 8; ++i) { p[i * 4 + 0] = a.v[i]; p[i * 4 + 1] = b.v[i]; p[i * 4 + 2] = c.v[i]; p[i * 4 + 3] = d.v[i]; } }
+inline void SIMD_LoadDeinterleave3(const fp32* p, fp32x8& a, fp32x8& b, fp32x8& c) { for (int32 i = 0; i < 8; ++i) { a.v[i] = p[i * 3 + 0]; b.v[i] = p[i * 3 + 1]; c.v[i] = p[i * 3 + 2]; } }
+inline void SIMD_StoreInterleave3(fp32* p, fp32x8 a, fp32x8 b, fp32x8 c) { for (int32 i = 0; i < 8; ++i) { p[i * 3 + 0] = a.v[i]; p[i * 3 + 1] = b.v[i]; p[i * 3 + 2] = c.v[i]; } }
+
+// 整数の加算は他の実装と同じく桁あふれしたら折り返す
+inline int32x8 SIMD_SetInt(int32 a) { int32x8 r; for (int32 i = 0; i < 8; ++i) { r.v[i] = a; } return r; }
+inline int32x8 SIMD_RampInt(int32 Step) { int32x8 r; for (int32 i = 0; i < 8; ++i) { r.v[i] = Step * i; } return r; }
+inline int32x8 SIMD_AddInt(int32x8 a, int32x8 b) { int32x8 r; for (int32 i = 0; i < 8; ++i) { r.v[i] = int32(uint32(a.v[i]) + uint32(b.v[i])); } return r; }
+inline fp32x8 SIMD_CmpGTInt(int32x8 a, int32x8 b) { SIMD_SCALAR_OP(SIMD_MaskValue(a.v[i] > b.v[i])); }
+inline void SIMD_StoreInt(int32* p, int32x8 a) { for (int32 i = 0; i < 8; ++i) { p[i] = a.v[i]; } }
+
+inline fp32x8 SIMD_Abs(fp32x8 a) { SIMD_SCALAR_OP(fabsf(a.v[i])); }
+inline fp32x8 SIMD_Floor(fp32x8 a) { SIMD_SCALAR_OP(floorf(a.v[i])); }
+inline int32x8 SIMD_ToInt(fp32x8 a) { int32x8 r; for (int32 i = 0; i < 8; ++i) { r.v[i] = int32(lrintf(a.v[i])); } return r; }
+
+#undef SIMD_SCALAR_OP
+
+#endif//defined(SIMD_USE_AVX2)
+
+//======================================================================================================
+// a * b + c
+//======================================================================================================
+inline fp32x8 SIMD_MulAdd(fp32x8 a, fp32x8 b, fp32x8 c) { return SIMD_Add(SIMD_Mul(a, b), c); }
+
+//======================================================================================================
+// 全レーンの最大値
+//======================================================================================================
+inline fp32 SIMD_ReduceMax(fp32x8 a)
+{
+	fp32 v[SIMD_WIDTH];
+	SIMD_Store(v, a);
+	auto r = v[0];
+	for (int32 i = 1; i < SIMD_WIDTH; ++i)
+	{
+		r = (r < v[i]) ? v[i] : r;
+	}
+	return r;
+}
+
+//======================================================================================================
+// 立っている一番下のビットの位置（Maskは0以外）
+//======================================================================================================
+inline int32 SIMD_BitScan(int32 Mask)
+{
+#if defined(_MSC_VER)
+	unsigned long Index;
+	_BitScanForward(&Index, uint32(Mask));
+	return int32(Index);
+#else//defined(_MSC_VER)
+	return __builtin_ctz(uint32(Mask));
+#endif//defined(_MSC_VER)
+}
@@ -0,0 +1,89 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Misc/File.h>
+
+//======================================================================================
+//
+//======================================================================================
+File::File()
+	: _pFile(nullptr)
+{
+}
+
+//======================================================================================
+//
+//======================================================================================
+File::~File()
+{
+	Close();
+}
+
+//======================================================================================
+//
+//======================================================================================
+bool File::Open(const char* pFileName, const char* pMode)
+{
+	Close();
+
+	_pFile = fopen(pFileName, pMode);
+	return _pFile != nullptr;
+}
+
+//======================================================================================
+//
+//======================================================================================
+void File::Close()
+{
+	if (_pFile != nullptr)
+	{
+		fclose(_pFile);
+		_pFile = nullptr;
+	}
+}
+
+//======================================================================================
+//
+//======================================================================================
+bool File::IsOpen() const
+{
+	return _pFile != nullptr;
+}
+
+//======================================================================================
+//
+//======================================================================================
+uint64 File::Read(void* pBuffer, uint64 Size)
+{
+	if (_pFile == nullptr) return 0;
+	return fread(pBuffer, 1, size_t(Size), _pFile);
+}
+
+//======================================================================================
+//
+//======================================================================================
+uint64 File::Write(const void* pBuffer, uint64 Size)
+{
+	if (_pFile == nullptr) return 0;
+	return fwrite(pBuffer, 1, size_t(Size), _pFile);
+}
+
+//======================================================================================
+//
+//======================================================================================
+bool File::ReadLine(char* pBuffer, int32 Size)
+{
+	if (_pFile == nullptr) return false;
+	return fgets(pBuffer, Size, _pFile) != nullptr;
+}
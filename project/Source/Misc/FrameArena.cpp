@@ -0,0 +1,102 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Misc/FrameArena.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static const uint64 ARENA_ALIGNMENT = 64;
+
+//======================================================================================================
+//
+//======================================================================================================
+FrameArena::FrameArena(uint64 BlockSize, uint64 MaxSize)
+	: _Offset(0)
+	, _BlockCount(0)
+	, _BlockSize((BlockSize + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+	, _PeakSize(0)
+{
+	_BlockLimit = int32(std::min<uint64>(MAX_BLOCK_COUNT, std::max<uint64>(1, MaxSize / _BlockSize)));
+	for (auto&& pBlock : _pBlocks)
+	{
+		pBlock = nullptr;
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+FrameArena::~FrameArena()
+{
+	for (auto&& pBlock : _pBlocks)
+	{
+		delete[] pBlock.load();
+		pBlock = nullptr;
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void* FrameArena::Allocate(uint64 Size)
+{
+	Size = (Size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+	if (Size > _BlockSize) return nullptr;
+
+	for (;;)
+	{
+		// ブロックをまたいだ場合は残りを捨てて次のブロックから取り直す
+		const auto Offset = _Offset.fetch_add(Size);
+		const auto BlockNo = Offset / _BlockSize;
+		const auto BlockOffset = Offset % _BlockSize;
+		if (BlockNo >= uint64(_BlockLimit)) return nullptr;
+		if (BlockOffset + Size > _BlockSize) continue;
+
+		uint8* pBlock = _pBlocks[BlockNo].load(std::memory_order_acquire);
+		if (pBlock == nullptr)
+		{
+			std::lock_guard<std::mutex> Lock(_Mutex);
+			pBlock = _pBlocks[BlockNo].load(std::memory_order_relaxed);
+			if (pBlock == nullptr)
+			{
+				pBlock = new (std::nothrow) uint8[_BlockSize + ARENA_ALIGNMENT];
+				if (pBlock == nullptr) return nullptr;
+				_pBlocks[BlockNo].store(pBlock, std::memory_order_release);
+				_BlockCount++;
+			}
+		}
+
+		const auto Address = (uintptr_t(pBlock) + ARENA_ALIGNMENT - 1) & ~uintptr_t(ARENA_ALIGNMENT - 1);
+		return reinterpret_cast<void*>(Address + BlockOffset);
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void FrameArena::Reset()
+{
+	_PeakSize = std::max(_PeakSize, GetUsedSize());
+	_Offset = 0;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+uint64 FrameArena::GetUsedSize() const
+{
+	return std::min(_Offset.load(), _BlockSize * uint64(_BlockLimit));
+}
@@ -0,0 +1,48 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#pragma once
+
+//======================================================================================================
+// フレーム単位で使い捨てるメモリ領域
+//  固定サイズのブロックを必要になった分だけ確保して、Resetしても解放せずに次のフレームで使い回す
+//  Allocateは複数スレッドから同時に呼べる（Resetは誰も使っていないときに呼ぶこと）
+//======================================================================================================
+class FrameArena
+{
+private:
+	enum { MAX_BLOCK_COUNT = 1024 };
+
+	std::atomic<uint8*>		_pBlocks[MAX_BLOCK_COUNT];
+	std::atomic<uint64>		_Offset;
+	std::atomic<int32>		_BlockCount;
+	std::mutex				_Mutex;
+	uint64					_BlockSize;
+	int32					_BlockLimit;
+	uint64					_PeakSize;
+
+public:
+	FrameArena(uint64 BlockSize, uint64 MaxSize);
+	~FrameArena();
+
+public:
+	// 上限を超えたらnullptrを返す
+	void* Allocate(uint64 Size);
+	void Reset();
+
+	uint64 GetUsedSize() const;
+	uint64 GetReservedSize() const { return _BlockSize * uint64(_BlockCount.load()); }
+	uint64 GetPeakSize() const { return _PeakSize; }
+};
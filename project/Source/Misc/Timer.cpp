@@ -40,6 +40,15 @@ uint64 Timer::GetMicro()
 	return std::chrono::duration_cast<std::chrono::microseconds>(TimeNow - _Origin).count();
 }
 
+//======================================================================================
+//
+//======================================================================================
+uint64 Timer::GetNano()
+{
+	std::chrono::high_resolution_clock::time_point TimeNow = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(TimeNow - _Origin).count();
+}
+
 //======================================================================================
 //
 //======================================================================================
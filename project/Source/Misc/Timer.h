@@ -27,6 +27,7 @@ private:
 public:
 	Timer();
 	uint64 GetMicro();
+	uint64 GetNano();
 	uint64 Start();
 	uint64 Elapsed();
 };
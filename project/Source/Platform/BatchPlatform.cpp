@@ -0,0 +1,228 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Platform/BatchPlatform.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+BatchPlatform::BatchPlatform(const std::vector<CameraPose>& Poses, const char* pOutputDirectory)
+	: _pApp(nullptr)
+	, _Poses(Poses)
+	, _OutputDirectory(pOutputDirectory != nullptr ? pOutputDirectory : "")
+	, _UpdateCount(0)
+	, _PresentCount(0)
+	, _StartTime(0)
+	, _EndTime(0)
+{
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+BatchPlatform::~BatchPlatform()
+{
+	Finalize();
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+bool BatchPlatform::Initialize(Application* pApp, int32 Width, int32 Height, int32 PageCount)
+{
+	_pApp = pApp;
+
+	_Surfaces.resize(PageCount);
+	for (auto&& Surface : _Surfaces)
+	{
+		Surface.resize(Width * Height);
+	}
+
+	_UpdateCount = 0;
+	_PresentCount = 0;
+	_Profiles.clear();
+	_Profiles.reserve(_Poses.size());
+	return true;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void BatchPlatform::Finalize()
+{
+	_Surfaces.clear();
+	_pApp = nullptr;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+bool BatchPlatform::Update()
+{
+	const auto PoseCount = int32(_Poses.size());
+	if (_UpdateCount == 0)
+	{
+		_StartTime = _Timer.GetMicro();
+	}
+
+	// ページを切り替えてから出力されるので最後のフレームの転送用に1回多く回す
+	if (_UpdateCount > PoseCount) return false;
+
+	// 直前のExecuteの計測結果を記録する（_Profiles[i]はi番目のカメラの描画）
+	if (_UpdateCount > 0)
+	{
+		_Profiles.push_back(TaskSystem::Instance().GetProfile());
+	}
+
+	if (_UpdateCount < PoseCount)
+	{
+		_pApp->SetCamera(_Poses[_UpdateCount]);
+	}
+
+	_UpdateCount++;
+	return true;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+Color* BatchPlatform::GetSurface(int32 Page)
+{
+	return &(_Surfaces[Page][0]);
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void BatchPlatform::Present(int32 Page, const FrameBuffer<Color>& Buffer)
+{
+	// 最初の転送はまだ何も描画されていないページ
+	const auto Index = _PresentCount++;
+	if (Index == 0) return;
+
+	const auto FrameNo = Index - 1;
+	if (!_OutputDirectory.empty())
+	{
+		char FileName[1024];
+		snprintf(FileName, sizeof(FileName), "%s/frame_%05d.bmp", _OutputDirectory.c_str(), FrameNo);
+		if (!SaveToBMP(FileName, Buffer))
+		{
+			fprintf(stderr, "failed to write %s\n", FileName);
+		}
+	}
+
+	if (FrameNo == int32(_Poses.size()) - 1)
+	{
+		_EndTime = _Timer.GetMicro();
+	}
+}
+
+//======================================================================================================
+// 名前が同じフェーズを探す
+//======================================================================================================
+static int32 FindPhase(const std::vector<TaskProfile::Phase>& Phases, const char* pName)
+{
+	for (size_t i = 0; i < Phases.size(); ++i)
+	{
+		const auto* pDst = Phases[i].pName;
+		if ((pDst == pName) || ((pDst != nullptr) && (pName != nullptr) && (strcmp(pDst, pName) == 0)))
+		{
+			return int32(i);
+		}
+	}
+	return -1;
+}
+
+//======================================================================================================
+// 全フレームの平均
+//  フェーズの数や並びはフレームごとに変わることがあるので名前で対応を取り、
+//  フェーズとスレッドはそれぞれ実際に含まれていたフレームの数で割る
+//======================================================================================================
+TaskProfile BatchPlatform::GetAverageProfile() const
+{
+	TaskProfile Result = {};
+	if (_Profiles.empty()) return Result;
+
+	std::vector<int32> PhaseFrameCounts;
+	std::vector<int32> WorkerFrameCounts;
+	for (auto&& Profile : _Profiles)
+	{
+		Result.FrameTime += Profile.FrameTime;
+
+		for (auto&& Src : Profile.Phases)
+		{
+			auto Index = FindPhase(Result.Phases, Src.pName);
+			if (Index < 0)
+			{
+				Index = int32(Result.Phases.size());
+				Result.Phases.push_back(TaskProfile::Phase{ Src.pName, 0.0, 0.0, 0 });
+				PhaseFrameCounts.push_back(0);
+			}
+
+			auto& Dst = Result.Phases[Index];
+			Dst.WallTime += Src.WallTime;
+			Dst.BusyTime += Src.BusyTime;
+			Dst.JobCount += Src.JobCount;
+			PhaseFrameCounts[Index]++;
+		}
+
+		for (auto&& Src : Profile.Workers)
+		{
+			if (Src.CoreNo >= int32(Result.Workers.size()))
+			{
+				for (auto i = int32(Result.Workers.size()); i <= Src.CoreNo; ++i)
+				{
+					Result.Workers.push_back(TaskProfile::Worker{ i, 0.0, 0.0, 0.0, 0 });
+					WorkerFrameCounts.push_back(0);
+				}
+			}
+
+			auto& Dst = Result.Workers[Src.CoreNo];
+			Dst.BusyTime += Src.BusyTime;
+			Dst.BarrierTime += Src.BarrierTime;
+			Dst.IdleTime += Src.IdleTime;
+			Dst.JobCount += Src.JobCount;
+			WorkerFrameCounts[Src.CoreNo]++;
+		}
+	}
+
+	const auto ProfileCount = int32(_Profiles.size());
+	Result.FrameNo = ProfileCount;
+	Result.FrameTime /= fp64(ProfileCount);
+	for (size_t i = 0; i < Result.Phases.size(); ++i)
+	{
+		auto& Phase = Result.Phases[i];
+		const auto Count = PhaseFrameCounts[i];
+		Phase.WallTime /= fp64(Count);
+		Phase.BusyTime /= fp64(Count);
+		Phase.JobCount /= Count;
+	}
+	for (size_t i = 0; i < Result.Workers.size(); ++i)
+	{
+		auto& Worker = Result.Workers[i];
+		const auto Count = std::max(1, WorkerFrameCounts[i]);
+		Worker.BusyTime /= fp64(Count);
+		Worker.BarrierTime /= fp64(Count);
+		Worker.IdleTime /= fp64(Count);
+		Worker.JobCount /= Count;
+	}
+	return Result;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void BatchPlatform::ShowStatus(fp32 FPS, uint32 TriangleCount, uint32 VertexCount)
+{
+}
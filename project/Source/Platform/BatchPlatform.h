@@ -0,0 +1,56 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#pragma once
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Platform/Platform.h>
+#include <Application/Application.h>
+#include <Misc/Timer.h>
+#include <TaskSystem/TaskSystem.h>
+
+//======================================================================================================
+// カメラのリストを順番に描画してファイルに書き出すプラットフォーム
+//======================================================================================================
+class BatchPlatform : public IPlatform
+{
+	Application*					_pApp;
+	std::vector<CameraPose>			_Poses;
+	std::string						_OutputDirectory;
+	std::vector<std::vector<Color>>	_Surfaces;
+	int32							_UpdateCount;
+	int32							_PresentCount;
+	uint64							_StartTime;
+	uint64							_EndTime;
+	Timer							_Timer;
+	std::vector<TaskProfile>		_Profiles;
+
+public:
+	BatchPlatform(const std::vector<CameraPose>& Poses, const char* pOutputDirectory);
+	virtual ~BatchPlatform();
+
+	virtual bool Initialize(Application* pApp, int32 Width, int32 Height, int32 PageCount);
+	virtual void Finalize();
+	virtual bool Update();
+	virtual Color* GetSurface(int32 Page);
+	virtual void Present(int32 Page, const FrameBuffer<Color>& Buffer);
+	virtual void ShowStatus(fp32 FPS, uint32 TriangleCount, uint32 VertexCount);
+
+	int32 GetFrameCount() const { return std::max(0, _PresentCount - 1); }
+	fp64 GetElapsedSecond() const { return fp64(_EndTime - _StartTime) / 1000000.0; }
+	const std::vector<TaskProfile>& GetProfiles() const { return _Profiles; }
+	TaskProfile GetAverageProfile() const;
+};
@@ -0,0 +1,59 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Platform/CapturePlatform.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+CapturePlatform::CapturePlatform(const std::vector<CameraPose>& Poses)
+	: BatchPlatform(Poses, nullptr)
+	, _PoseCount(int32(Poses.size()))
+{
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+CapturePlatform::~CapturePlatform()
+{
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void CapturePlatform::Capture(int32 Page, const ColorBuffer& Color, const DepthBuffer& Depth, const GBuffer& GBuffer)
+{
+	// 最後の転送用に1回多く回る分は同じカメラなので保持しない
+	if (int32(_Frames.size()) >= _PoseCount) return;
+
+	const int32 Width = Color.GetWidth();
+	const int32 Height = Color.GetHeight();
+	const int32 PixelCount = Width * Height;
+
+	_Frames.push_back(Frame());
+	auto& Dst = _Frames.back();
+	Dst.Width = Width;
+	Dst.Height = Height;
+	Dst.Colors.assign(Color.GetPixelPointer(), Color.GetPixelPointer() + PixelCount);
+	Dst.Depths.assign(Depth.GetPixelPointer(), Depth.GetPixelPointer() + PixelCount);
+	Dst.TriangleIds.resize(PixelCount);
+
+	const auto* pGBuffer = GBuffer.GetPixelPointer();
+	for (int32 i = 0; i < PixelCount; ++i)
+	{
+		Dst.TriangleIds[i] = pGBuffer[i].TriangleId;
+	}
+}
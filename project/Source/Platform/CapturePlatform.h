@@ -0,0 +1,49 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#pragma once
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Platform/BatchPlatform.h>
+
+//======================================================================================================
+// カメラのリストを順番に描画して各フレームのバッファの内容を保持するプラットフォーム
+//======================================================================================================
+class CapturePlatform : public BatchPlatform
+{
+public:
+	struct Frame
+	{
+		int32				Width;
+		int32				Height;
+		std::vector<Color>	Colors;
+		std::vector<fp32>	Depths;
+		std::vector<uint16>	TriangleIds;
+	};
+
+private:
+	int32				_PoseCount;
+	std::vector<Frame>	_Frames;
+
+public:
+	CapturePlatform(const std::vector<CameraPose>& Poses);
+	virtual ~CapturePlatform();
+
+	virtual void Capture(int32 Page, const ColorBuffer& Color, const DepthBuffer& Depth, const GBuffer& GBuffer);
+
+	const std::vector<Frame>& GetFrames() const { return _Frames; }
+};
@@ -0,0 +1,112 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Platform/HeadlessPlatform.h>
+#include <TaskSystem/TaskSystem.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+HeadlessPlatform::HeadlessPlatform(int32 FrameCount, const char* pOutputFileName)
+	: _OutputFileName(pOutputFileName != nullptr ? pOutputFileName : "")
+	, _FrameCount(FrameCount)
+	, _UpdateCount(0)
+	, _PresentCount(0)
+{
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+HeadlessPlatform::~HeadlessPlatform()
+{
+	Finalize();
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+bool HeadlessPlatform::Initialize(Application* pApp, int32 Width, int32 Height, int32 PageCount)
+{
+	_Surfaces.resize(PageCount);
+	for (auto&& Surface : _Surfaces)
+	{
+		Surface.resize(Width * Height);
+	}
+
+	_UpdateCount = 0;
+	_PresentCount = 0;
+	return true;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void HeadlessPlatform::Finalize()
+{
+	_Surfaces.clear();
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+bool HeadlessPlatform::Update()
+{
+	// ページを切り替えてから出力されるので最後のフレームの転送用に1回多く回す
+	return _UpdateCount++ <= _FrameCount;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+Color* HeadlessPlatform::GetSurface(int32 Page)
+{
+	return &(_Surfaces[Page][0]);
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void HeadlessPlatform::Present(int32 Page, const FrameBuffer<Color>& Buffer)
+{
+	// 最初の転送はまだ何も描画されていないページ
+	if (_PresentCount++ != _FrameCount) return;
+	if (_OutputFileName.empty()) return;
+
+	if (!SaveToBMP(_OutputFileName.c_str(), Buffer))
+	{
+		fprintf(stderr, "failed to write %s\n", _OutputFileName.c_str());
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void HeadlessPlatform::ShowStatus(fp32 FPS, uint32 TriangleCount, uint32 VertexCount)
+{
+	printf("(FPS:%.1f) (Polygon: %u/frame) (Vertex: %u/frame)", FPS, TriangleCount, VertexCount);
+
+	// 直前のフレームのフェーズごとの時間
+	const auto& Profile = TaskSystem::Instance().GetProfile();
+	fp64 BarrierTime = 0.0;
+	for (auto&& Phase : Profile.Phases)
+	{
+		printf(" (%s: %.2fms)", Phase.pName != nullptr ? Phase.pName : "-", Phase.WallTime / 1000.0);
+	}
+	for (auto&& Worker : Profile.Workers)
+	{
+		BarrierTime += Worker.BarrierTime;
+	}
+	printf(" (Barrier: %.2fms)\n", BarrierTime / 1000.0);
+}
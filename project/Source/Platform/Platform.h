@@ -0,0 +1,53 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#pragma once
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Renderer/FrameBuffer.h>
+#include <Renderer/Renderer.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+class Application;
+
+//======================================================================================================
+// 出力先（ウィンドウ・ヘッドレスなど）ごとの差分を吸収するインターフェース
+//======================================================================================================
+struct IPlatform
+{
+	virtual ~IPlatform() {}
+
+	// 出力先のサーフェイスを生成する
+	virtual bool Initialize(Application* pApp, int32 Width, int32 Height, int32 PageCount) = 0;
+	virtual void Finalize() = 0;
+
+	// メッセージ処理など、falseを返したらループを抜ける
+	virtual bool Update() = 0;
+
+	// レンダリング先になるサーフェイス（nullptrならFrameBuffer側で確保する）
+	virtual Color* GetSurface(int32 Page) = 0;
+
+	// 描画が完了したページを出力する（タスクジョブ内から呼ばれる）
+	virtual void Present(int32 Page, const FrameBuffer<Color>& Buffer) = 0;
+
+	// FPSなどの状況の表示
+	virtual void ShowStatus(fp32 FPS, uint32 TriangleCount, uint32 VertexCount) = 0;
+
+	// Executeが終わって描画が完了したページのバッファ（メインスレッドから呼ばれる）
+	virtual void Capture(int32 Page, const ColorBuffer& Color, const DepthBuffer& Depth, const GBuffer& GBuffer) {}
+};
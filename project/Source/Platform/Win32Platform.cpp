@@ -0,0 +1,292 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Platform/Win32Platform.h>
+#include <Application/Application.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static Application* _pApp;
+static bool _RequireSaveScene;
+
+//======================================================================================================
+//
+//======================================================================================================
+void DIBBuffer::Create(HWND hWnd, HDC hWindowDC, int32 w, int32 h)
+{
+	_Width = w;
+	_Height = h;
+
+	BITMAPINFOHEADER BmpInfoHeader = { sizeof(BITMAPINFOHEADER) };
+	BmpInfoHeader.biWidth = +_Width;
+	BmpInfoHeader.biHeight = -_Height;	// BMPはYが下から上だけど高さをマイナスにすると上から下になる
+	BmpInfoHeader.biPlanes = 1;
+	BmpInfoHeader.biBitCount = 32;
+	BmpInfoHeader.biCompression = BI_RGB;
+
+	_hWnd = hWnd;
+	_hWindowDC = hWindowDC;
+	_hBitmap = ::CreateDIBSection(_hWindowDC, (BITMAPINFO*)&BmpInfoHeader, DIB_RGB_COLORS, (void**)&_pSurface, nullptr, 0);
+	_hSurfaceDC = ::CreateCompatibleDC(_hWindowDC);
+	::SelectObject(_hSurfaceDC, _hBitmap);
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void DIBBuffer::Release()
+{
+	::ReleaseDC(_hWnd, _hSurfaceDC);
+	::DeleteObject(_hBitmap);
+	::ReleaseDC(_hWnd, _hWindowDC);
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+LRESULT CALLBACK MessageProc(HWND hWnd, uint32 Msg, WPARAM wParam, LPARAM lParam)
+{
+	static POINT CursorPosition;
+
+	switch (Msg)
+	{
+		//---------------------------------------------
+	case WM_LBUTTONDOWN:
+	case WM_RBUTTONDOWN:
+	case WM_MBUTTONDOWN:
+		::SetCapture(hWnd);
+		::GetCursorPos(&CursorPosition);
+		break;
+		//---------------------------------------------
+	case WM_LBUTTONUP:
+	case WM_RBUTTONUP:
+	case WM_MBUTTONUP:
+		::ReleaseCapture();
+		break;
+		//---------------------------------------------
+	case WM_MOUSEMOVE:
+		{
+			POINT NewCursorPosition;
+			::GetCursorPos(&NewCursorPosition);
+			const int32 mx = NewCursorPosition.x - CursorPosition.x;
+			const int32 my = NewCursorPosition.y - CursorPosition.y;
+			CursorPosition = NewCursorPosition;
+			if (_pApp == nullptr)
+			{
+				break;
+			}
+			if (wParam & MK_LBUTTON)
+			{
+				_pApp->OnLefeMouseDrag(mx, my);
+			}
+			if (wParam & MK_RBUTTON)
+			{
+				_pApp->OnRightMouseDrag(mx, my);
+			}
+			if (wParam & MK_MBUTTON)
+			{
+				_pApp->OnWheelMouseDrag(mx, my);
+			}
+		}
+		break;
+		//---------------------------------------------
+	case WM_KEYDOWN:
+		switch (wParam)
+		{
+		case VK_ESCAPE:
+			::SendMessage(hWnd, WM_CLOSE, 0, 0);
+			break;
+		case VK_RETURN:
+			_RequireSaveScene = true;
+			break;
+		}
+		break;
+		//---------------------------------------------
+	case WM_CREATE:
+		::SetCursor(LoadCursor(nullptr, IDC_ARROW));
+		break;
+		//---------------------------------------------
+	case WM_CLOSE:
+		::PostMessage(hWnd, WM_DESTROY, 0, 0);
+		break;
+		//---------------------------------------------
+	case WM_DESTROY:
+		PostQuitMessage(0);
+		break;
+	}
+
+	return DefWindowProc(hWnd, Msg, wParam, lParam);
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+Win32Platform::Win32Platform(HINSTANCE hInstance)
+	: _hInstance(hInstance)
+	, _hWnd(nullptr)
+	, _hWindowDC(nullptr)
+{
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+Win32Platform::~Win32Platform()
+{
+	Finalize();
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+bool Win32Platform::Initialize(Application* pApp, int32 Width, int32 Height, int32 PageCount)
+{
+	WNDCLASS WindowClass;
+
+	_pApp = pApp;
+	_RequireSaveScene = false;
+
+	//------------------------------------------------------------
+	// ウィンドウクラス
+	//------------------------------------------------------------
+	WindowClass.style = CS_DBLCLKS;
+	WindowClass.lpfnWndProc = MessageProc;
+	WindowClass.cbClsExtra = 0;
+	WindowClass.cbWndExtra = 0;
+	WindowClass.hInstance = _hInstance;
+	WindowClass.hIcon = nullptr;
+	WindowClass.hCursor = LoadCursor(nullptr, IDC_ARROW);
+	WindowClass.hbrBackground = (HBRUSH)GetStockObject(WHITE_BRUSH);
+	WindowClass.lpszMenuName = nullptr;
+	WindowClass.lpszClassName = APPLICATION_TITLE;
+	RegisterClass(&WindowClass);
+
+	//------------------------------------------------------------
+	// ウィンドウ生成
+	//------------------------------------------------------------
+	auto x = 0;
+	auto y = 0;
+	auto w = Width;
+	auto h = Height;
+	auto Style = WS_POPUP | WS_CAPTION | WS_SYSMENU;
+	RECT Rect = { 0, 0, w, h };
+	::AdjustWindowRect(&Rect, Style, FALSE);
+	w = Rect.right - Rect.left;
+	h = Rect.bottom - Rect.top;
+	x = ::GetSystemMetrics(SM_CXSCREEN) / 2 - w / 2;
+	y = ::GetSystemMetrics(SM_CYSCREEN) / 2 - h / 2;
+
+	_hWnd = ::CreateWindowEx(
+		WS_EX_APPWINDOW,
+		APPLICATION_TITLE,
+		APPLICATION_TITLE,
+		Style,
+		x, y, w, h,
+		nullptr,
+		nullptr,
+		_hInstance,
+		nullptr);
+	if (_hWnd == nullptr)
+	{
+		return false;
+	}
+
+	::ShowWindow(_hWnd, SW_NORMAL);
+	::UpdateWindow(_hWnd);
+
+	//--------------------------------------------------------------------------
+	// バッファ生成
+	//--------------------------------------------------------------------------
+	_hWindowDC = ::GetDC(_hWnd);
+
+	_DIBBuffers.resize(PageCount);
+	for (auto&& Buffer : _DIBBuffers)
+	{
+		Buffer.Create(_hWnd, _hWindowDC, Width, Height);
+	}
+
+	return true;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void Win32Platform::Finalize()
+{
+	for (auto&& Buffer : _DIBBuffers)
+	{
+		Buffer.Release();
+	}
+	_DIBBuffers.clear();
+
+	_pApp = nullptr;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+bool Win32Platform::Update()
+{
+	MSG Msg;
+
+	while (::PeekMessage(&Msg, nullptr, 0, 0, PM_REMOVE))
+	{
+		if (Msg.message == WM_QUIT)
+		{
+			return false;
+		}
+		::TranslateMessage(&Msg);
+		::DispatchMessage(&Msg);
+	}
+
+	return true;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+Color* Win32Platform::GetSurface(int32 Page)
+{
+	return _DIBBuffers[Page].Surface();
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void Win32Platform::Present(int32 Page, const FrameBuffer<Color>& Buffer)
+{
+	::BitBlt(
+		_hWindowDC, 0, 0, _DIBBuffers[Page].Width(), _DIBBuffers[Page].Height(),
+		_DIBBuffers[Page].SurfaceDC(), 0, 0, SRCCOPY);
+	if (_RequireSaveScene)
+	{
+		_RequireSaveScene = false;
+		SaveToBMP("ScreenShot.bmp", Buffer);
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void Win32Platform::ShowStatus(fp32 FPS, uint32 TriangleCount, uint32 VertexCount)
+{
+	wchar_t Text[300];
+	swprintf_s(Text, 300, L"%s (FPS:%.1lf) (Polygon: %u/frame) (Vertex: %u/frame)",
+		APPLICATION_TITLE,
+		FPS,
+		TriangleCount,
+		VertexCount);
+	::SetWindowText(_hWnd, Text);
+}
@@ -0,0 +1,77 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+//======================================================================================================
+//
+//======================================================================================================
+#pragma once
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Platform/Platform.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+class DIBBuffer
+{
+private:
+	Color*	_pSurface;
+	int32	_Width;
+	int32	_Height;
+	HBITMAP	_hBitmap;
+	HWND	_hWnd;
+	HDC		_hWindowDC;
+	HDC		_hSurfaceDC;
+
+public:
+	Color* Surface()
+	{
+		return _pSurface;
+	}
+	HDC SurfaceDC()
+	{
+		return _hSurfaceDC;
+	}
+	int32 Width()
+	{
+		return _Width;
+	}
+	int32 Height()
+	{
+		return _Height;
+	}
+	void Create(HWND hWnd, HDC hWindowDC, int32 w, int32 h);
+	void Release();
+};
+
+//======================================================================================================
+// ウィンドウにDIBを転送して表示するプラットフォーム
+//======================================================================================================
+class Win32Platform : public IPlatform
+{
+	HINSTANCE				_hInstance;
+	HWND					_hWnd;
+	HDC						_hWindowDC;
+	std::vector<DIBBuffer>	_DIBBuffers;
+
+public:
+	Win32Platform(HINSTANCE hInstance);
+	virtual ~Win32Platform();
+
+	virtual bool Initialize(Application* pApp, int32 Width, int32 Height, int32 PageCount);
+	virtual void Finalize();
+	virtual bool Update();
+	virtual Color* GetSurface(int32 Page);
+	virtual void Present(int32 Page, const FrameBuffer<Color>& Buffer);
+	virtual void ShowStatus(fp32 FPS, uint32 TriangleCount, uint32 VertexCount);
+};
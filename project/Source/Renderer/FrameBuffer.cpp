@@ -13,3 +13,67 @@
 //
 //======================================================================================================
 #include <Renderer/FrameBuffer.h>
+#include <Misc/File.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+bool SaveToBMP(const char* pFileName, const FrameBuffer<Color>& Buffer)
+{
+#pragma pack(push, 2)
+	struct BitmapFileHeader
+	{
+		uint16	bfType;
+		uint32	bfSize;
+		uint16	bfReserved1;
+		uint16	bfReserved2;
+		uint32	bfOffBits;
+	};
+#pragma pack(pop)
+	struct BitmapInfoHeader
+	{
+		uint32	biSize;
+		int32	biWidth;
+		int32	biHeight;
+		uint16	biPlanes;
+		uint16	biBitCount;
+		uint32	biCompression;
+		uint32	biSizeImage;
+		int32	biXPelsPerMeter;
+		int32	biYPelsPerMeter;
+		uint32	biClrUsed;
+		uint32	biClrImportant;
+	};
+
+	BitmapInfoHeader BmpIH = { sizeof(BitmapInfoHeader) };
+	BmpIH.biWidth = Buffer.GetWidth();
+	BmpIH.biHeight = Buffer.GetHeight();
+	BmpIH.biPlanes = 1;
+	BmpIH.biBitCount = 32;
+	BmpIH.biCompression = 0;	// BI_RGB
+
+	BitmapFileHeader BmpH = {};
+	BmpH.bfType = 'MB';
+	BmpH.bfSize = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader) + sizeof(uint32) * BmpIH.biWidth * BmpIH.biHeight;
+	BmpH.bfOffBits = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader);
+
+	File BmpFile;
+	if (!BmpFile.Open(pFileName, "wb"))
+	{
+		return false;
+	}
+
+	BmpFile.Write(&BmpH, sizeof(BitmapFileHeader));
+	BmpFile.Write(&BmpIH, sizeof(BitmapInfoHeader));
+
+	// BMPはYが下から上なので最終行から書き出す
+	const Color* pPixel = Buffer.GetPixelPointer() + (BmpIH.biWidth * BmpIH.biHeight);
+	for (int32 y = 0; y < BmpIH.biHeight; ++y)
+	{
+		pPixel -= BmpIH.biWidth;
+		BmpFile.Write(pPixel, sizeof(uint32) * BmpIH.biWidth);
+	}
+
+	BmpFile.Close();
+	return true;
+}
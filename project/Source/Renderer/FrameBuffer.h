@@ -25,6 +25,9 @@ private:
 	int32	_Width;
 	int32	_Height;
 	bool	_IsInternal;
+	T		_ClearValue;
+	bool	_HasClearValue;	// 一度でもClearされたか
+	std::vector<uint8>	_ClearedTiles;	// タイルごとにクリアした値のままか
 
 public:
 	FrameBuffer()
@@ -32,6 +35,8 @@ public:
 		, _Width(0)
 		, _Height(0)
 		, _IsInternal(true)
+		, _ClearValue()
+		, _HasClearValue(false)
 	{
 	}
 	FrameBuffer(T* pPixel, int32 Width, int32 Height)
@@ -39,11 +44,14 @@ public:
 		, _Width(Width)
 		, _Height(Height)
 		, _IsInternal(pPixel == nullptr)
+		, _ClearValue()
+		, _HasClearValue(false)
 	{
 		if (_IsInternal)
 		{
 			_pPixel = new T[Width * Height];
 		}
+		_ClearedTiles.assign(GetTileCountX() * GetTileCountY(), 0);
 	}
 	~FrameBuffer()
 	{
@@ -60,16 +68,51 @@ public:
 		_Width = 0;
 		_Height = 0;
 		_IsInternal = true;
+		_ClearedTiles.clear();
 	}
 
 public:
+	// 全体を埋めて、その値をタイルごとのクリアで使う
 	void Clear(T pixel)
 	{
-		int32 count = int32(_Width * _Height);
-		while (count-- > 0)
+		std::fill_n(_pPixel, _Width * _Height, pixel);
+		_ClearValue = pixel;
+		_HasClearValue = true;
+		std::fill(_ClearedTiles.begin(), _ClearedTiles.end(), uint8(1));
+	}
+
+	// タイルを最後にClearした値で埋める
+	// 前に埋めてからSetTileDirtyされていないタイルはクリアした値のままなので書き込まない
+	// 作成やResizeの後は全タイルが未初期化なので、先にClearで値を決めておくこと
+	//  一度もClearしていなければ埋める値が決まっていないので何もしない
+	void ClearTile(int32 tx, int32 ty)
+	{
+		ASSERT(_HasClearValue);
+		if (!_HasClearValue) return;
+
+		auto& IsCleared = _ClearedTiles[tx + (ty * GetTileCountX())];
+		if (IsCleared) return;
+
+		const auto x = tx * BUFFER_TILE_SIZE_X;
+		const auto y = ty * BUFFER_TILE_SIZE_Y;
+		const auto w = std::min(BUFFER_TILE_SIZE_X, _Width - x);
+		const auto h = std::min(BUFFER_TILE_SIZE_Y, _Height - y);
+		for (int32 i = 0; i < h; ++i)
 		{
-			_pPixel[count] = pixel;
+			std::fill_n(_pPixel + x + ((y + i) * _Width), w, _ClearValue);
 		}
+		IsCleared = 1;
+	}
+
+	// タイルにクリアした値以外を書き込むときに呼ぶ
+	void SetTileDirty(int32 tx, int32 ty)
+	{
+		_ClearedTiles[tx + (ty * GetTileCountX())] = 0;
+	}
+
+	const T& GetClearValue() const
+	{
+		return _ClearValue;
 	}
 
 	void Resize(int32 Width, int32 Height)
@@ -80,6 +123,9 @@ public:
 		_Height = Height;
 		_IsInternal = true;
 		_pPixel = new T[Width * Height];
+		_ClearValue = T();
+		_HasClearValue = false;
+		_ClearedTiles.assign(GetTileCountX() * GetTileCountY(), 0);
 	}
 
 	bool SetPixel(int32 x, int32 y, T color)
@@ -137,4 +183,19 @@ public:
 	{
 		return _Height;
 	}
+
+	int32 GetTileCountX() const
+	{
+		return (_Width + (BUFFER_TILE_SIZE_X - 1)) / BUFFER_TILE_SIZE_X;
+	}
+
+	int32 GetTileCountY() const
+	{
+		return (_Height + (BUFFER_TILE_SIZE_Y - 1)) / BUFFER_TILE_SIZE_Y;
+	}
 };
+
+//======================================================================================================
+//
+//======================================================================================================
+bool SaveToBMP(const char* pFileName, const FrameBuffer<Color>& Buffer);
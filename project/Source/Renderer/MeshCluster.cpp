@@ -0,0 +1,249 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Renderer/MeshCluster.h>
+
+//======================================================================================================
+// 溜めた三角形からクラスタを1つ作る
+//======================================================================================================
+static void AddCluster(
+	std::vector<MeshCluster>& Clusters,
+	std::vector<uint16>& ClusterVertices,
+	std::vector<uint16>& ClusterIndices,
+	std::vector<uint32>& ClusterTriangles,
+	std::vector<int32>& LocalIndices,
+	const std::vector<uint16>& Vertices,
+	const std::vector<uint32>& Triangles,
+	const Vector3* pPositions,
+	const uint16* pIndex)
+{
+	MeshCluster Cluster;
+	Cluster.TriangleOffset = uint32(ClusterTriangles.size());
+	Cluster.TriangleCount = uint16(Triangles.size());
+	Cluster.VertexOffset = uint32(ClusterVertices.size());
+	Cluster.VertexCount = uint16(Vertices.size());
+
+	// 境界球（バウンディングボックスの中心から一番遠い頂点まで）
+	Vector3 Min = pPositions[Vertices[0]];
+	Vector3 Max = Min;
+	for (auto v : Vertices)
+	{
+		Vector_Min(Min, Min, pPositions[v]);
+		Vector_Max(Max, Max, pPositions[v]);
+	}
+	Vector_Add(Cluster.Center, Min, Max);
+	Vector_Mul(Cluster.Center, Cluster.Center, 0.5f);
+
+	fp32 RadiusSq = 0.0f;
+	for (auto v : Vertices)
+	{
+		Vector3 d;
+		RadiusSq = std::max(RadiusSq, Vector_LengthSq(Vector_Sub(d, pPositions[v], Cluster.Center)));
+	}
+	Cluster.Radius = sqrtf(RadiusSq);
+
+	// 法線の円錐（面の法線の平均を軸にして、一番離れた法線との角度の分だけ判定を狭める）
+	// 面の法線はレンダラーで表向きになる巻き順からカメラに向かう側にとる
+	Vector3 Normals[MESH_CLUSTER_TRIANGLE_COUNT];
+	int32 NormalCount = 0;
+	Vector3 Axis = { 0.0f, 0.0f, 0.0f };
+	for (auto t : Triangles)
+	{
+		const auto& p0 = pPositions[pIndex[t * 3 + 0]];
+		const auto& p1 = pPositions[pIndex[t * 3 + 1]];
+		const auto& p2 = pPositions[pIndex[t * 3 + 2]];
+
+		Vector3 e1, e2, n;
+		Vector_Sub(e1, p1, p0);
+		Vector_Sub(e2, p2, p0);
+		Vector_CrossProduct(n, e1, e2);
+		if (Vector_LengthSq(n) <= 0.0f) continue;
+
+		Vector_Normalize(n, n);
+		Vector_Add(Axis, Axis, n);
+		Normals[NormalCount++] = n;
+	}
+
+	Cluster.ConeAxis = Vector3{ 0.0f, 0.0f, 0.0f };
+	Cluster.ConeCutoff = 1.0f;
+	if (Vector_LengthSq(Axis) > 0.0f)
+	{
+		Vector_Normalize(Axis, Axis);
+
+		auto MinDot = 1.0f;
+		for (int32 i = 0; i < NormalCount; ++i)
+		{
+			MinDot = std::min(MinDot, Vector_DotProduct(Normals[i], Axis));
+		}
+
+		// 法線が90度以上広がっていたらどこから見ても表向きの面があり得る
+		if (MinDot > 0.0f)
+		{
+			Cluster.ConeAxis = Axis;
+			Cluster.ConeCutoff = sqrtf(1.0f - (MinDot * MinDot));
+		}
+	}
+
+	for (auto t : Triangles)
+	{
+		for (int32 i = 0; i < 3; ++i)
+		{
+			ClusterIndices.push_back(uint16(LocalIndices[pIndex[t * 3 + i]]));
+		}
+		ClusterTriangles.push_back(t);
+	}
+	for (auto v : Vertices)
+	{
+		LocalIndices[v] = -1;
+	}
+
+	ClusterVertices.insert(ClusterVertices.end(), Vertices.begin(), Vertices.end());
+	Clusters.push_back(Cluster);
+}
+
+//======================================================================================================
+// 頂点を共有する三角形をたどってクラスタを育てる
+//  新しく増える頂点が一番少ない三角形から順に足していき、頂点か三角形の数があふれたら次のクラスタにする
+//  つながっている三角形がなくなったら、まだ使っていない最初の三角形から続ける
+//======================================================================================================
+void MeshCluster_Build(
+	std::vector<MeshCluster>& Clusters,
+	std::vector<uint16>& ClusterVertices,
+	std::vector<uint16>& ClusterIndices,
+	std::vector<uint32>& ClusterTriangles,
+	const Vector3* pPositions,
+	int32 VertexCount,
+	const uint16* pIndex,
+	int32 IndexCount)
+{
+	const int32 TriangleCount = IndexCount / 3;
+
+	Clusters.clear();
+	ClusterVertices.clear();
+	ClusterIndices.clear();
+	ClusterTriangles.clear();
+	ClusterIndices.reserve(TriangleCount * 3);
+	ClusterTriangles.reserve(TriangleCount);
+
+	// 頂点ごとにその頂点を使う三角形の表
+	std::vector<int32> AdjacencyOffsets(VertexCount + 1, 0);
+	for (int32 i = 0; i < TriangleCount * 3; ++i)
+	{
+		AdjacencyOffsets[pIndex[i] + 1]++;
+	}
+	for (int32 v = 0; v < VertexCount; ++v)
+	{
+		AdjacencyOffsets[v + 1] += AdjacencyOffsets[v];
+	}
+	std::vector<uint32> Adjacencies(AdjacencyOffsets[VertexCount]);
+	{
+		std::vector<int32> Offsets(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+		for (int32 i = 0; i < TriangleCount * 3; ++i)
+		{
+			Adjacencies[Offsets[pIndex[i]]++] = uint32(i / 3);
+		}
+	}
+
+	// 元の頂点番号からクラスタ内の番号への表（使っていない頂点は-1）
+	std::vector<int32> LocalIndices(VertexCount, -1);
+	std::vector<bool> IsUsed(TriangleCount, false);
+	std::vector<uint16> Vertices;
+	std::vector<uint32> Triangles;
+	std::vector<uint32> Candidates;
+
+	const auto GetNewVertexCount = [&](uint32 t)
+	{
+		const auto i0 = pIndex[t * 3 + 0];
+		const auto i1 = pIndex[t * 3 + 1];
+		const auto i2 = pIndex[t * 3 + 2];
+		int32 Count = 0;
+		Count += (LocalIndices[i0] < 0) ? 1 : 0;
+		Count += ((LocalIndices[i1] < 0) && (i1 != i0)) ? 1 : 0;
+		Count += ((LocalIndices[i2] < 0) && (i2 != i0) && (i2 != i1)) ? 1 : 0;
+		return Count;
+	};
+
+	const auto AddTriangle = [&](uint32 t)
+	{
+		IsUsed[t] = true;
+		Triangles.push_back(t);
+		for (int32 i = 0; i < 3; ++i)
+		{
+			const auto v = pIndex[t * 3 + i];
+			if (LocalIndices[v] >= 0) continue;
+
+			LocalIndices[v] = int32(Vertices.size());
+			Vertices.push_back(v);
+			for (int32 a = AdjacencyOffsets[v]; a < AdjacencyOffsets[v + 1]; ++a)
+			{
+				if (!IsUsed[Adjacencies[a]]) Candidates.push_back(Adjacencies[a]);
+			}
+		}
+	};
+
+	int32 NextSeed = 0;
+	for (;;)
+	{
+		// つながっている三角形から新しい頂点が一番少ないものを選ぶ
+		int32 Best = -1;
+		int32 BestNewVertexCount = 4;
+		for (size_t i = 0; i < Candidates.size(); )
+		{
+			const auto t = Candidates[i];
+			if (IsUsed[t])
+			{
+				Candidates[i] = Candidates.back();
+				Candidates.pop_back();
+				continue;
+			}
+
+			const auto NewVertexCount = GetNewVertexCount(t);
+			if (NewVertexCount < BestNewVertexCount)
+			{
+				Best = int32(t);
+				BestNewVertexCount = NewVertexCount;
+				if (NewVertexCount == 0) break;
+			}
+			++i;
+		}
+
+		// つながっている三角形がなければ使っていない最初の三角形
+		if (Best < 0)
+		{
+			while ((NextSeed < TriangleCount) && IsUsed[NextSeed]) ++NextSeed;
+			if (NextSeed == TriangleCount) break;
+
+			Best = NextSeed;
+			BestNewVertexCount = GetNewVertexCount(uint32(Best));
+		}
+
+		// 頂点か三角形の数があふれるならそこまででクラスタを作る
+		if ((int32(Vertices.size()) + BestNewVertexCount > MESH_CLUSTER_VERTEX_COUNT) || (int32(Triangles.size()) == MESH_CLUSTER_TRIANGLE_COUNT))
+		{
+			AddCluster(Clusters, ClusterVertices, ClusterIndices, ClusterTriangles, LocalIndices, Vertices, Triangles, pPositions, pIndex);
+			Vertices.clear();
+			Triangles.clear();
+			Candidates.clear();
+			continue;
+		}
+
+		AddTriangle(uint32(Best));
+	}
+
+	if (!Triangles.empty())
+	{
+		AddCluster(Clusters, ClusterVertices, ClusterIndices, ClusterTriangles, LocalIndices, Vertices, Triangles, pPositions, pIndex);
+	}
+}
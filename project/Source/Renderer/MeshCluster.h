@@ -0,0 +1,63 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#pragma once
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Math/Math.h>
+
+//======================================================================================================
+// メッシュを分割した小さな三角形のまとまり（クラスタ）
+//  頂点はクラスタごとに使うものだけを並べて、インデックスはその中の番号で持つ
+//  三角形はクラスタの順に並べなおして、元のメッシュでの番号も持つ
+//======================================================================================================
+struct MeshCluster
+{
+	Vector3		Center;			// 境界球
+	fp32		Radius;
+	Vector3		ConeAxis;		// 面の法線の範囲を表す円錐（ConeCutoffが1なら判定しない）
+	fp32		ConeCutoff;
+	uint32		TriangleOffset;	// クラスタの三角形の表の位置
+	uint32		VertexOffset;	// クラスタの頂点の表の位置
+	uint16		TriangleCount;
+	uint16		VertexCount;
+};
+
+//======================================================================================================
+// 頂点を共有する三角形をまとめてクラスタに分割する
+//  ClusterVerticesにはクラスタごとに使う頂点の元の番号、ClusterIndicesにはクラスタの順に並べた三角形の
+//  クラスタ内の頂点の番号、ClusterTrianglesにはその三角形の元の番号が入る
+//======================================================================================================
+void MeshCluster_Build(
+	std::vector<MeshCluster>& Clusters,
+	std::vector<uint16>& ClusterVertices,
+	std::vector<uint16>& ClusterIndices,
+	std::vector<uint32>& ClusterTriangles,
+	const Vector3* pPositions,
+	int32 VertexCount,
+	const uint16* pIndex,
+	int32 IndexCount);
+
+//======================================================================================================
+// カメラからクラスタの三角形がすべて裏向きに見えるか
+//======================================================================================================
+inline bool MeshCluster_IsBackFacing(const MeshCluster& Cluster, const Vector3& CameraPosition)
+{
+	Vector3 Direction;
+	Vector_Sub(Direction, Cluster.Center, CameraPosition);
+	return Vector_DotProduct(Direction, Cluster.ConeAxis) >= (Cluster.ConeCutoff * Vector_Length(Direction)) + Cluster.Radius;
+}
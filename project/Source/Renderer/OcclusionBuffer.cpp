@@ -0,0 +1,278 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Renderer/OcclusionBuffer.h>
+#include <Renderer/Renderer.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static const int32	OCCLUSION_BUFFER_WIDTH	= SCREEN_WIDTH  / OCCLUSION_BUFFER_SCALE;
+static const int32	OCCLUSION_BUFFER_HEIGHT	= SCREEN_HEIGHT / OCCLUSION_BUFFER_SCALE;
+static const uint32	OCCLUSION_FULL_MASK		= (OCCLUSION_BUFFER_SCALE * OCCLUSION_BUFFER_SCALE == 32) ? 0xFFFFFFFF : ((1U << (OCCLUSION_BUFFER_SCALE * OCCLUSION_BUFFER_SCALE)) - 1U);
+
+// ガードバンドからはみ出す三角形の辺を内側に寄せる幅（1/16ピクセル単位で1/4ピクセル）
+//  レンダラーは画面の端で切り取った頂点を1/16ピクセルに丸め直すので、辺が元の三角形から最大で約0.18ピクセルずれる
+static const fp64	OCCLUSION_EDGE_MARGIN	= 4.0;
+// 固定小数点にする画面座標の範囲（これより遠い頂点のある三角形は書き込まない）
+static const fp32	OCCLUSION_MAX_COORD		= fp32(1 << 22);
+
+static_assert(OCCLUSION_BUFFER_SCALE * OCCLUSION_BUFFER_SCALE <= 32, "マスクは32ビットに収める");
+static_assert((SCREEN_WIDTH % OCCLUSION_BUFFER_SCALE) == 0, "画面の幅は縮小率の倍数にする");
+static_assert((SCREEN_HEIGHT % OCCLUSION_BUFFER_SCALE) == 0, "画面の高さは縮小率の倍数にする");
+
+//======================================================================================================
+// 画面上の範囲に重なるピクセルの範囲（画面外ならfalse）
+//======================================================================================================
+static bool GetPixelRect(fp32 MinX, fp32 MinY, fp32 MaxX, fp32 MaxY, int32& x0, int32& y0, int32& x1, int32& y1)
+{
+	x0 = std::max(int32(floorf(std::max(MinX, -1.0f))), 0);
+	y0 = std::max(int32(floorf(std::max(MinY, -1.0f))), 0);
+	x1 = std::min(int32(floorf(std::min(MaxX, SCREEN_WIDTH_F))), SCREEN_WIDTH - 1);
+	y1 = std::min(int32(floorf(std::min(MaxY, SCREEN_HEIGHT_F))), SCREEN_HEIGHT - 1);
+	if ((x0 > x1) || (y0 > y1)) return false;
+
+	x0 /= OCCLUSION_BUFFER_SCALE;
+	y0 /= OCCLUSION_BUFFER_SCALE;
+	x1 /= OCCLUSION_BUFFER_SCALE;
+	y1 /= OCCLUSION_BUFFER_SCALE;
+	return true;
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+OcclusionBuffer::OcclusionBuffer()
+	: _Pixels(OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT)
+{
+	Clear();
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+OcclusionBuffer::~OcclusionBuffer()
+{
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void OcclusionBuffer::Clear()
+{
+	for (auto&& Pix : _Pixels)
+	{
+		Pix.FullZ = FLT_MAX;
+		Pix.WorkZ = 0.0f;
+		Pix.WorkMask = 0;
+	}
+}
+
+//======================================================================================================
+// 遮蔽物のメッシュを書き込む（頂点の変換はレンダラーのジオメトリ処理と同じ）
+//======================================================================================================
+void OcclusionBuffer::RenderMesh(const Vector3* pPositions, int32 VertexCount, const uint16* pIndex, int32 IndexCount, const Matrix& mViewProj)
+{
+	_Positions.resize(VertexCount);
+	for (int32 i = 0; i < VertexCount; ++i)
+	{
+		Matrix_Transform4x4(_Positions[i], pPositions[i], mViewProj);
+	}
+
+	for (int32 i = 0; i + 2 < IndexCount; i += 3)
+	{
+		RenderTriangle(_Positions[pIndex[i + 0]], _Positions[pIndex[i + 1]], _Positions[pIndex[i + 2]]);
+	}
+}
+
+//======================================================================================================
+// 三角形を1つ書き込む
+//  クリッピングはしないので、前後のクリップ面にかかる三角形は書き込まない（遮蔽物が減るだけなので安全）
+//  覆っているかどうかはレンダラーと同じ1/16ピクセルの丸めと28.4の固定小数点の辺の式で画面のピクセル単位で調べる
+//  ・ガードバンドの中の三角形はレンダラーも切り取らないので、左上ルールも含めてレンダラーが塗るピクセルと一致する
+//  ・ガードバンドからはみ出す三角形はレンダラーが切り取った分だけ辺がずれるので、
+//    辺からOCCLUSION_EDGE_MARGINより内側のピクセルだけを覆っていることにする（遮蔽物が減るだけなので安全）
+//======================================================================================================
+void OcclusionBuffer::RenderTriangle(const Vector4& v0, const Vector4& v1, const Vector4& v2)
+{
+	const Vector4* pVertices[] = { &v0, &v1, &v2 };
+
+	Vector3 p[3];
+	int32 X[3], Y[3];
+	bool IsInGuardBand = true;
+	for (int32 i = 0; i < 3; ++i)
+	{
+		const auto& v = *pVertices[i];
+		if ((v.w <= 0.0f) || (v.z < -v.w) || (v.z > v.w)) return;
+
+		// レンダラーが切り取らずに使うか（GetClipCodeのガードバンドと同じ判定）
+		const auto GuardW = v.w * GUARD_BAND_SCALE;
+		if ((v.x < -GuardW) || (v.x > GuardW) || (v.y < -GuardW) || (v.y > GuardW)) IsInGuardBand = false;
+
+		const auto invW = 1.0f / v.w;
+		p[i].x = floorf((+v.x * invW * 0.5f + 0.5f) * SCREEN_WIDTH_F * 16.0f) / 16.0f;
+		p[i].y = floorf((-v.y * invW * 0.5f + 0.5f) * SCREEN_HEIGHT_F * 16.0f) / 16.0f;
+		p[i].z = v.z * invW;
+		if (!(fabsf(p[i].x) <= OCCLUSION_MAX_COORD) || !(fabsf(p[i].y) <= OCCLUSION_MAX_COORD)) return;
+
+		X[i] = ToFixed(p[i].x);
+		Y[i] = ToFixed(p[i].y);
+	}
+
+	// 裏向きの面はレンダラーでも描画されないので遮蔽物にしない
+	const auto FixedDenom = (int64(X[1] - X[0]) * (Y[2] - Y[0])) - (int64(Y[1] - Y[0]) * (X[2] - X[0]));
+	if (FixedDenom <= 0) return;
+
+	const auto bbMinX = std::min(p[0].x, std::min(p[1].x, p[2].x));
+	const auto bbMinY = std::min(p[0].y, std::min(p[1].y, p[2].y));
+	const auto bbMaxX = std::max(p[0].x, std::max(p[1].x, p[2].x));
+	const auto bbMaxY = std::max(p[0].y, std::max(p[1].y, p[2].y));
+	const auto MaxZ = std::max(p[0].z, std::max(p[1].z, p[2].z));
+
+	int32 x0, y0, x1, y1;
+	if (!GetPixelRect(bbMinX, bbMinY, bbMaxX, bbMaxY, x0, y0, x1, y1)) return;
+
+	// 辺の式はp0を原点にした28.4の固定小数点（RasterizeTriangleと同じ）
+	//  ガードバンドの外の頂点もあるのでint64で求める
+	int64 ea[3], eb[3], ec[3];
+	for (int32 i = 0; i < 3; ++i)
+	{
+		const auto j = (i + 1) % 3;
+		const auto k = (i + 2) % 3;
+		const auto a = Y[j] - Y[k];
+		const auto b = X[k] - X[j];
+		ea[i] = a;
+		eb[i] = b;
+		ec[i] = (i == 0) ? FixedDenom : 0;
+		if (IsInGuardBand)
+		{
+			if (!IsTopLeftEdge(a, b)) ec[i] -= 1;
+		}
+		else
+		{
+			// 辺の式の値は辺からの距離 × 辺の長さ
+			ec[i] -= int64(ceil(OCCLUSION_EDGE_MARGIN * sqrt((fp64(a) * a) + (fp64(b) * b))));
+		}
+	}
+
+	// 深度はp0を原点にした平面の式
+	const auto InvDenom = 256.0f / fp32(FixedDenom);
+	const auto za = ((fp32(ea[0]) * p[0].z) + (fp32(ea[1]) * p[1].z) + (fp32(ea[2]) * p[2].z)) * InvDenom / 16.0f;
+	const auto zb = ((fp32(eb[0]) * p[0].z) + (fp32(eb[1]) * p[1].z) + (fp32(eb[2]) * p[2].z)) * InvDenom / 16.0f;
+	const auto zc = p[0].z;
+
+	for (auto y = y0; y <= y1; ++y)
+	{
+		for (auto x = x0; x <= x1; ++x)
+		{
+			const auto fx0 = fp32(x * OCCLUSION_BUFFER_SCALE) + 0.5f - p[0].x;
+			const auto fy0 = fp32(y * OCCLUSION_BUFFER_SCALE) + 0.5f - p[0].y;
+
+			// 左上のピクセルの中心での辺の式の値から1ピクセル（16）ずつ進める
+			const auto FixedX = int64(x * OCCLUSION_BUFFER_SCALE * 16 + 8) - X[0];
+			const auto FixedY = int64(y * OCCLUSION_BUFFER_SCALE * 16 + 8) - Y[0];
+			int64 Row[3];
+			for (int32 i = 0; i < 3; ++i)
+			{
+				Row[i] = (ea[i] * FixedX) + (eb[i] * FixedY) + ec[i];
+			}
+
+			uint32 Mask = 0;
+			uint32 Bit = 1;
+			for (int32 sy = 0; sy < OCCLUSION_BUFFER_SCALE; ++sy)
+			{
+				auto e0 = Row[0], e1 = Row[1], e2 = Row[2];
+				for (int32 sx = 0; sx < OCCLUSION_BUFFER_SCALE; ++sx, Bit <<= 1)
+				{
+					if ((e0 >= 0) && (e1 >= 0) && (e2 >= 0)) Mask |= Bit;
+					e0 += ea[0] * 16;
+					e1 += ea[1] * 16;
+					e2 += ea[2] * 16;
+				}
+				Row[0] += eb[0] * 16;
+				Row[1] += eb[1] * 16;
+				Row[2] += eb[2] * 16;
+			}
+			if (Mask == 0) continue;
+
+			// 覆っている範囲の深度の最大値（平面の式の四隅の最大値と頂点の最大値の小さい方）
+			const auto Span = fp32(OCCLUSION_BUFFER_SCALE - 1);
+			const auto ax = std::max(za * fx0, za * (fx0 + Span));
+			const auto by = std::max(zb * fy0, zb * (fy0 + Span));
+			const auto TriZ = std::min(ax + by + zc, MaxZ);
+
+			// 全部埋まっている面より奥なら何も変わらない
+			auto& Pix = _Pixels[(y * OCCLUSION_BUFFER_WIDTH) + x];
+			if (TriZ >= Pix.FullZ) continue;
+
+			Pix.WorkZ = (Pix.WorkMask == 0) ? TriZ : std::max(Pix.WorkZ, TriZ);
+			Pix.WorkMask |= Mask;
+			if (Pix.WorkMask == OCCLUSION_FULL_MASK)
+			{
+				Pix.FullZ = std::min(Pix.FullZ, Pix.WorkZ);
+				Pix.WorkMask = 0;
+			}
+		}
+	}
+}
+
+//======================================================================================================
+// バウンディングボックスが見える可能性があるか
+//  ボックスの一番手前が覆っているピクセルすべての確定した深度以上なら、深度テストに通るピクセルはない
+//======================================================================================================
+bool OcclusionBuffer::IsVisible(const Vector3& BoundingMin, const Vector3& BoundingMax, const Matrix& mViewProj) const
+{
+	auto bbMinX = FLT_MAX, bbMinY = FLT_MAX, bbMaxX = -FLT_MAX, bbMaxY = -FLT_MAX;
+	auto MinZ = FLT_MAX;
+	for (int32 i = 0; i < 8; ++i)
+	{
+		const Vector3 Corner = {
+			(i & 1) ? BoundingMax.x : BoundingMin.x,
+			(i & 2) ? BoundingMax.y : BoundingMin.y,
+			(i & 4) ? BoundingMax.z : BoundingMin.z,
+		};
+
+		Vector4 v;
+		Matrix_Transform4x4(v, Corner, mViewProj);
+
+		// 手前のクリップ面にかかるものは判定しない
+		if ((v.w <= 0.0f) || (v.z < -v.w)) return true;
+
+		const auto invW = 1.0f / v.w;
+		const auto sx = (+v.x * invW * 0.5f + 0.5f) * SCREEN_WIDTH_F;
+		const auto sy = (-v.y * invW * 0.5f + 0.5f) * SCREEN_HEIGHT_F;
+		bbMinX = std::min(bbMinX, sx);
+		bbMinY = std::min(bbMinY, sy);
+		bbMaxX = std::max(bbMaxX, sx);
+		bbMaxY = std::max(bbMaxY, sy);
+		MinZ = std::min(MinZ, v.z * invW);
+	}
+
+	// 位置の丸めの分だけ1ピクセル広げる
+	// 画面外のものはクリッピングに任せる
+	int32 x0, y0, x1, y1;
+	if (!GetPixelRect(bbMinX - 1.0f, bbMinY - 1.0f, bbMaxX + 1.0f, bbMaxY + 1.0f, x0, y0, x1, y1)) return true;
+
+	for (auto y = y0; y <= y1; ++y)
+	{
+		const auto* pPixel = &_Pixels[(y * OCCLUSION_BUFFER_WIDTH) + x0];
+		for (auto x = x0; x <= x1; ++x, ++pPixel)
+		{
+			if (MinZ < pPixel->FullZ) return true;
+		}
+	}
+
+	return false;
+}
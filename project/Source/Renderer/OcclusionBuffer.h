@@ -0,0 +1,54 @@
+﻿/*
+ * MIT License
+ *  Copyright (c) 2019 SPARKCREATIVE
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *  @author Noriyuki Hiromoto <hrmtnryk@sparkfx.jp>
+*/
+
+
+//======================================================================================================
+//
+//======================================================================================================
+#pragma once
+
+//======================================================================================================
+//
+//======================================================================================================
+#include <Math/Math.h>
+
+//======================================================================================================
+// オクルージョンカリング用の低解像度の深度バッファ
+//  1ピクセルが画面のOCCLUSION_BUFFER_SCALE四方のピクセルに対応していて
+//  どのピクセルが遮蔽物で埋まったかをマスクで持ち、全部埋まった時点の深度の最大値を確定させる
+//  確定した深度は必ず実際の深度バッファ以上になるので、それより奥のバウンディングボックスは見えない
+//======================================================================================================
+class OcclusionBuffer
+{
+private:
+	struct Pixel
+	{
+		fp32	FullZ;		// 全部埋まった面の深度の最大値
+		fp32	WorkZ;		// 埋まりかけの面の深度の最大値
+		uint32	WorkMask;	// 埋まりかけの面が覆っている画面のピクセル
+	};
+
+private:
+	std::vector<Pixel>		_Pixels;
+	std::vector<Vector4>	_Positions;
+
+private:
+	void RenderTriangle(const Vector4& v0, const Vector4& v1, const Vector4& v2);
+
+public:
+	OcclusionBuffer();
+	~OcclusionBuffer();
+
+public:
+	void Clear();
+	void RenderMesh(const Vector3* pPositions, int32 VertexCount, const uint16* pIndex, int32 IndexCount, const Matrix& mViewProj);
+	bool IsVisible(const Vector3& BoundingMin, const Vector3& BoundingMax, const Matrix& mViewProj) const;
+};
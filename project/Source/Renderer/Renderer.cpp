@@ -14,6 +14,156 @@
 //======================================================================================================
 #include <Renderer/Renderer.h>
 #include <TaskSystem/TaskSystem.h>
+#include <Math/SIMD.h>
+
+//======================================================================================================
+// クリップ空間の頂点がどの面の外側にあるか
+//  面の内外はClipPointsと同じ判定（内側は0より大きい）
+//  GUARD_BANDは画面のGUARD_BAND_SCALE倍の範囲からはみ出している
+//======================================================================================================
+enum
+{
+	CLIP_CODE_LEFT			= 1 << 0,
+	CLIP_CODE_RIGHT			= 1 << 1,
+	CLIP_CODE_BOTTOM		= 1 << 2,
+	CLIP_CODE_TOP			= 1 << 3,
+	CLIP_CODE_NEAR			= 1 << 4,
+	CLIP_CODE_FAR			= 1 << 5,
+	CLIP_CODE_GUARD_BAND	= 1 << 6,
+};
+
+static uint32 GetClipCode(const Vector4& v)
+{
+	uint32 Code = 0;
+	if (v.w + v.x <= 0.0f) Code |= CLIP_CODE_LEFT;
+	if (v.w - v.x <= 0.0f) Code |= CLIP_CODE_RIGHT;
+	if (v.w + v.y <= 0.0f) Code |= CLIP_CODE_BOTTOM;
+	if (v.w - v.y <= 0.0f) Code |= CLIP_CODE_TOP;
+	if (v.w + v.z <= 0.0f) Code |= CLIP_CODE_NEAR;
+	if (v.w - v.z <= 0.0f) Code |= CLIP_CODE_FAR;
+
+	const auto GuardW = v.w * GUARD_BAND_SCALE;
+	if ((GuardW <= 0.0f) || (v.x < -GuardW) || (v.x > GuardW) || (v.y < -GuardW) || (v.y > GuardW)) Code |= CLIP_CODE_GUARD_BAND;
+	return Code;
+}
+
+//======================================================================================================
+// クリップ空間の位置を画面に投影する（xyは1/16ピクセルに丸めた画面座標、zはz/w、wは1/w）
+//======================================================================================================
+static Vector4 ProjectToScreen(const Vector4& v)
+{
+	const auto invW = 1.0f / v.w;
+	const auto screen_x = (+v.x * invW * 0.5f + 0.5f) * SCREEN_WIDTH_F;
+	const auto screen_y = (-v.y * invW * 0.5f + 0.5f) * SCREEN_HEIGHT_F;
+	return Vector4{
+		floorf(screen_x * 16.0f) / 16.0f,
+		floorf(screen_y * 16.0f) / 16.0f,
+		v.z * invW,
+		invW,
+	};
+}
+
+//======================================================================================================
+// 切り取る前の三角形のクリップ空間の頂点から属性の平面の式を求める
+//  属性qについてq/wは正規化デバイス座標の1次式 a * x/w + b * y/w + c なので、
+//  各頂点で q = a * x + b * y + c * w になり、行が (x, y, w) の行列の逆行列で (a, b, c) が求まる
+//  頂点を画面に投影しないのでwが0以下の頂点があってもよく、1/16ピクセルへの丸めの影響も受けない
+//  視点を通る（画面上で線になる）三角形はfalseを返す
+//======================================================================================================
+static bool MakeTrianglePlanes(TrianglePlanes& Dst, const Vector4& c0, const Vector4& c1, const Vector4& c2, const Vector2& t0, const Vector2& t1, const Vector2& t2)
+{
+	// 逆行列の列は r1 × r2、r2 × r0、r0 × r1 を行列式で割ったもの
+	const fp64 r[3][3] = {
+		{ c0.x, c0.y, c0.w },
+		{ c1.x, c1.y, c1.w },
+		{ c2.x, c2.y, c2.w },
+	};
+	fp64 m[3][3];
+	for (int32 i = 0; i < 3; ++i)
+	{
+		const auto& u = r[(i + 1) % 3];
+		const auto& v = r[(i + 2) % 3];
+		m[i][0] = (u[1] * v[2]) - (u[2] * v[1]);
+		m[i][1] = (u[2] * v[0]) - (u[0] * v[2]);
+		m[i][2] = (u[0] * v[1]) - (u[1] * v[0]);
+	}
+	const auto Det = (r[0][0] * m[0][0]) + (r[0][1] * m[0][1]) + (r[0][2] * m[0][2]);
+	if (Det == 0.0) return false;
+
+	// 正規化デバイス座標の式を画面座標の式にする
+	//  x/w = 2 * x / SCREEN_WIDTH - 1、y/w = 1 - 2 * y / SCREEN_HEIGHT
+	const auto InvDet = 1.0 / Det;
+	const auto MakePlane = [&](fp64 q0, fp64 q1, fp64 q2)
+	{
+		const auto a = ((q0 * m[0][0]) + (q1 * m[1][0]) + (q2 * m[2][0])) * InvDet;
+		const auto b = ((q0 * m[0][1]) + (q1 * m[1][1]) + (q2 * m[2][1])) * InvDet;
+		const auto c = ((q0 * m[0][2]) + (q1 * m[1][2]) + (q2 * m[2][2])) * InvDet;
+		return ScreenPlane{ a * (2.0 / SCREEN_WIDTH_F), b * (-2.0 / SCREEN_HEIGHT_F), c - a + b };
+	};
+
+	Dst.Depth		= MakePlane(c0.z, c1.z, c2.z);
+	Dst.InvW		= MakePlane(1.0, 1.0, 1.0);
+	Dst.TexCoord[0]	= MakePlane(t0.x, t1.x, t2.x);
+	Dst.TexCoord[1]	= MakePlane(t0.y, t1.y, t2.y);
+	return true;
+}
+
+//======================================================================================================
+// 外積（面積の2倍）を28.4の固定小数点で求める（単位は1/256ピクセル^2）
+//======================================================================================================
+static int64 GetFixedDenom(const Vector4& p0, const Vector4& p1, const Vector4& p2)
+{
+	const auto X0 = ToFixed(p0.x), Y0 = ToFixed(p0.y);
+	const auto X1 = ToFixed(p1.x), Y1 = ToFixed(p1.y);
+	const auto X2 = ToFixed(p2.x), Y2 = ToFixed(p2.y);
+	return (int64(X1 - X0) * (Y2 - Y0)) - (int64(Y1 - Y0) * (X2 - X0));
+}
+
+//======================================================================================================
+// 画面に投影した三角形がピクセルを塗る可能性があるか
+//  裏向きや面積0の三角形と、バウンディングボックスにピクセルの中心を1つも含まない三角形は塗らない
+//======================================================================================================
+static bool IsTriangleRasterizable(const Vector4& p0, const Vector4& p1, const Vector4& p2)
+{
+	// RasterizeTriangleの裏向きの判定と同じ式
+	if (GetFixedDenom(p0, p1, p2) <= 0) return false;
+
+	const auto bbMinX = std::min(p0.x, std::min(p1.x, p2.x));
+	const auto bbMaxX = std::max(p0.x, std::max(p1.x, p2.x));
+	const auto bbMinY = std::min(p0.y, std::min(p1.y, p2.y));
+	const auto bbMaxY = std::max(p0.y, std::max(p1.y, p2.y));
+	if (ceilf(bbMinX - 0.5f) > floorf(bbMaxX - 0.5f)) return false;
+	if (ceilf(bbMinY - 0.5f) > floorf(bbMaxY - 0.5f)) return false;
+
+	return true;
+}
+
+//======================================================================================================
+// GBufferの法線の展開（八面体に投影した2成分から戻す、圧縮はRasterizeTileTriangleで行う）
+//  長さは保存しないのでシェーディングで正規化する
+//======================================================================================================
+static Vector3 DecodeNormal(const int16 Src[2])
+{
+	auto x = fp32(Src[0]) * (1.0f / 32767.0f);
+	auto y = fp32(Src[1]) * (1.0f / 32767.0f);
+	const auto z = 1.0f - fabsf(x) - fabsf(y);
+	if (z < 0.0f)
+	{
+		const auto fx = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+		const auto fy = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+		x = fx;
+		y = fy;
+	}
+	return Vector3{ x, y, z };
+}
+
+//======================================================================================================
+// GBufferのUVの展開（テクスチャは繰り返すので小数部だけを16ビットで持つ）
+//======================================================================================================
+static fp32 DecodeTexCoord(uint16 t)
+{
+	return fp32(t) * (1.0f / 65536.0f);
+}
 
 //======================================================================================================
 //
@@ -21,17 +171,14 @@
 Renderer::Renderer()
 	: _pColorBuffer(nullptr)
 	, _pDepthBuffer(nullptr)
+	, _RasterizeArena(RASTERIZE_ARENA_BLOCK, MAX_RASTERIZE_ARENA)
+	, _IsOcclusionCullingEnabled(false)
+	, _IsVisibilityBufferEnabled(false)
+	, _IsTileShadingEnabled(false)
+	, _IsDepthOutputEnabled(false)
 {
-	// タイルごとのポリゴンデータの入れ物
-	// 並列処理されるので最初に入れ物を用意しておく
-	for (int32 y = 0; y < MAX_TILE_COUNT_Y; ++y)
-	{
-		for (int32 x = 0; x < MAX_TILE_COUNT_X; ++x)
-		{
-			_RasterizeDatas[y][x].Count = 0;
-			_RasterizeDatas[y][x].Triangles.resize(MAX_TILE_TRIANGLE_COUNT);
-		}
-	}
+	// セットアップ結果のブロックはアリーナから確保するので、表の大きさはアリーナの上限で決まる
+	_SetupBlocks.resize(size_t(MAX_RASTERIZE_ARENA / sizeof(RasterizeSetupBlock)), nullptr);
 
 	// テクスチャがセットされない場合用の白のダミーテクスチャ
 	_DummyTexture.Create(2, 2);
@@ -58,6 +205,46 @@ void Renderer::BeginDraw(ColorBuffer* pColorBuffer, DepthBuffer* pDepthBuffer, G
 
 	_RenderMeshDatas.clear();
 
+	// 前のフレームのラスタライズは終わっているのでタイルの入れ物をすべて返す
+	const auto DroppedCount = _DroppedTriangleCount.Load();
+	if (DroppedCount > 0)
+	{
+		fprintf(stderr, "rasterize arena is full (%llu MB): %d triangles dropped\n", (unsigned long long)(MAX_RASTERIZE_ARENA >> 20), DroppedCount);
+		_DroppedTriangleCount = 0;
+	}
+	_RasterizeArena.Reset();
+
+	// タイルごとのポリゴンデータの入れ物はジョブを実行するスレッドの数だけ用意する
+	// 中身は描画した三角形の数だけフレームのアリーナから確保する
+	const int32 WorkerCount = TaskSystem::Instance().GetWorkerCount();
+	if (int32(_RasterizeDatas.size()) != WorkerCount)
+	{
+		_RasterizeDatas.assign(WorkerCount, RasterizeData{});
+	}
+	for (auto&& Data : _RasterizeDatas)
+	{
+		Data.SetupBlockNo = 0;
+		Data.SetupCount = RASTERIZE_SETUP_BLOCK;
+	}
+	_SetupBlockCount = 0;
+
+	// 可視バッファは同じフレームのシェーディングで読み終わるので1枚だけ持つ
+	// 画面のバッファと同じく、三角形のないタイルだけをラスタライズでクリアする
+	// タイルごとにシェーディングするときはタイルの作業用のバッファを使うので要らない
+	const auto IsScreenVisibility = _IsVisibilityBufferEnabled && !_IsTileShadingEnabled;
+	if (IsScreenVisibility && (_VisibilityBuffer.GetWidth() != SCREEN_WIDTH))
+	{
+		_VisibilityBuffer.Resize(SCREEN_WIDTH, SCREEN_HEIGHT);
+		_VisibilityBuffer.Clear(INVALID_VISIBILITY_ID);
+	}
+
+	_ScreenTarget.OriginX		= 0;
+	_ScreenTarget.OriginY		= 0;
+	_ScreenTarget.Pitch			= SCREEN_WIDTH;
+	_ScreenTarget.pDepth		= _pDepthBuffer->GetPixelPointer();
+	_ScreenTarget.pGBuffer		= _pGBuffer->GetPixelPointer();
+	_ScreenTarget.pVisibility	= IsScreenVisibility ? _VisibilityBuffer.GetPixelPointer() : nullptr;
+
 	_Textures.clear();
 	_Textures.push_back(nullptr);
 
@@ -71,48 +258,129 @@ void Renderer::BeginDraw(ColorBuffer* pColorBuffer, DepthBuffer* pDepthBuffer, G
 void Renderer::EndDraw()
 {
 	Matrix_Multiply4x4(_mViewProj, _ViewMatrix, _ProjMatrix);
+	UpdateFrustumPlanes();
 
-	// メッシュ毎にジョブを作って並列処理する
-	// ・座標変換
-	// ・シザリング
-	// ・レンダリングする可能性のあるタイルへのデータの追加
+	Matrix mInvView;
+	Matrix_Inverse(mInvView, _ViewMatrix);
+	_CameraPosition = Vector3{ mInvView.w.x, mInvView.w.y, mInvView.w.z };
+
+	// 遮蔽物を低解像度の深度バッファに書き込むジョブ
+	// ・遮蔽物は少数の大きいメッシュなので1つのジョブでまとめて処理する
+	// ・ジオメトリ処理のジョブはバウンディングボックスが隠れていたら何もしない
+	bool IsOcclusionCulling = false;
+	if (_IsOcclusionCullingEnabled)
 	{
-		const int32 MeshCount = int32(_RenderMeshDatas.size());
-		for (int32 i = 0; i < MeshCount; ++i)
+		for (auto&& Mesh : _RenderMeshDatas)
 		{
-			TaskSystem::Instance().PushQue([&](void* pData) {
-				auto* pMesh = reinterpret_cast<RenderMeshData*>(pData);
-				const auto VertexCount = pMesh->pMeshData->GetVertexCount();
-				ASSERT(VertexCount <= MAX_VERTEX_CACHE_SIZE);
+			IsOcclusionCulling |= Mesh.IsOccluder;
+		}
+	}
 
-				const auto mWorld = pMesh->mWorld;
-				const auto mViewProj = _mViewProj;
+	if (IsOcclusionCulling)
+	{
+		TaskSystem::Instance().SetPhaseName("Occlusion");
 
-				thread_local static Vector4 Positions[MAX_VERTEX_CACHE_SIZE];
-				auto pPosTbl = pMesh->pMeshData->GetPosition();
-				for (auto i = 0; i < VertexCount; ++i)
-				{
-					Matrix_Transform4x4(Positions[i], pPosTbl[i], mViewProj);
-				}
+		TaskSystem::Instance().PushQue([this](void* pData) {
+			_OcclusionBuffer.Clear();
+			for (auto&& Mesh : _RenderMeshDatas)
+			{
+				if (!Mesh.IsOccluder || !IsInFrustum(Mesh.pMeshData)) continue;
+
+				const auto* pMeshData = Mesh.pMeshData;
+				_OcclusionBuffer.RenderMesh(
+					pMeshData->GetPosition(),
+					pMeshData->GetVertexCount(),
+					pMeshData->GetIndex(),
+					pMeshData->GetIndexCount(),
+					_mViewProj);
+			}
+		}, nullptr, "Occluder");
 
-				thread_local static Vector3 Normals[MAX_VERTEX_CACHE_SIZE];
-				auto pNormalTbl = pMesh->pMeshData->GetNormal();
-				for (auto i = 0; i < VertexCount; ++i)
-				{
-					Matrix_Transform3x3(Normals[i], pNormalTbl[i], mWorld);
-				}
+		TaskSystem::Instance().PushBarrier();
+	}
+
+	// メッシュを決まった大きさの範囲に分けてジョブを作り、大きなメッシュでも全スレッドで分担する
+	// ・クラスタに分割してあれば、三角形がGEOMETRY_BATCH_TRIANGLE_COUNT個になるまでクラスタをまとめる
+	// ・分割していなければ、先に頂点をGEOMETRY_BATCH_VERTEX_COUNT個ずつ変換してから三角形をGEOMETRY_BATCH_TRIANGLE_COUNT個ずつ処理する
+	// タイルではジョブの順番（DrawNo）に描画するので、ジョブの分け方によらず結果は変わらない
+	_VertexJobs.clear();
+	_GeometryJobs.clear();
+	for (auto&& Mesh : _RenderMeshDatas)
+	{
+		// 視錐台の外にあるメッシュはジョブを作らない
+		if (!IsInFrustum(Mesh.pMeshData)) continue;
 
-				RenderTriangle(
-					pMesh->TriangleId,
-					pMesh->TextureId,
-					pMesh->pMeshData,
-					Positions,
-					Normals,
-					pMesh->pMeshData->GetTexCoord(),
-					VertexCount,
-					pMesh->pMeshData->GetIndex(),
-					pMesh->pMeshData->GetIndexCount());
-			}, &_RenderMeshDatas[i]);
+		const auto* pMeshData = Mesh.pMeshData;
+		const auto IsMeshOcclusionCulling = IsOcclusionCulling && !Mesh.IsOccluder;
+		const auto ClusterCount = pMeshData->GetClusterCount();
+		if (ClusterCount == 0)
+		{
+			const auto VertexCount = pMeshData->GetVertexCount();
+			const auto TriangleCount = pMeshData->GetIndexCount() / 3;
+			ASSERT(VertexCount <= MAX_VERTEX_CACHE_SIZE);
+
+			// 変換済みの頂点はジョブの間で共有するのでアリーナに置く
+			Mesh.pPositions = reinterpret_cast<Vector4*>(_RasterizeArena.Allocate(sizeof(Vector4) * VertexCount));
+			Mesh.pNormals = reinterpret_cast<Vector3*>(_RasterizeArena.Allocate(sizeof(Vector3) * VertexCount));
+			if ((Mesh.pPositions == nullptr) || (Mesh.pNormals == nullptr))
+			{
+				_DroppedTriangleCount.Add(TriangleCount);
+				continue;
+			}
+
+			for (int32 i = 0; i < VertexCount; i += GEOMETRY_BATCH_VERTEX_COUNT)
+			{
+				_VertexJobs.push_back(VertexJobData{ &Mesh, i, std::min(GEOMETRY_BATCH_VERTEX_COUNT, VertexCount - i), IsMeshOcclusionCulling });
+			}
+			for (int32 i = 0; i < TriangleCount; i += GEOMETRY_BATCH_TRIANGLE_COUNT)
+			{
+				_GeometryJobs.push_back(GeometryJobData{ &Mesh, i, std::min(GEOMETRY_BATCH_TRIANGLE_COUNT, TriangleCount - i), IsMeshOcclusionCulling });
+			}
+			continue;
+		}
+
+		const auto* pClusters = pMeshData->GetCluster();
+		int32 Offset = 0;
+		int32 TriangleCount = 0;
+		for (int32 i = 0; i < ClusterCount; ++i)
+		{
+			TriangleCount += pClusters[i].TriangleCount;
+			if ((TriangleCount >= GEOMETRY_BATCH_TRIANGLE_COUNT) || (i == ClusterCount - 1))
+			{
+				_GeometryJobs.push_back(GeometryJobData{ &Mesh, Offset, i + 1 - Offset, IsMeshOcclusionCulling });
+				Offset = i + 1;
+				TriangleCount = 0;
+			}
+		}
+	}
+
+	// クラスタに分割していないメッシュの頂点変換
+	//  フレームごとにフェーズの並びが変わらないようにジョブがなくてもバリアは置く
+	{
+		TaskSystem::Instance().SetPhaseName("Vertex");
+
+		for (auto&& Job : _VertexJobs)
+		{
+			TaskSystem::Instance().PushQue([this](void* pData) {
+				ProcessVertices(*reinterpret_cast<const VertexJobData*>(pData));
+			}, &Job, "Vertices");
+		}
+
+		TaskSystem::Instance().PushBarrier();
+	}
+
+	// ジオメトリ処理
+	// ・シザリング
+	// ・レンダリングする可能性のあるタイルへのデータの追加
+	{
+		TaskSystem::Instance().SetPhaseName("Geometry");
+
+		for (auto&& Job : _GeometryJobs)
+		{
+			TaskSystem::Instance().PushQue([this](void* pData) {
+				auto* pJob = reinterpret_cast<const GeometryJobData*>(pData);
+				ProcessGeometry(*pJob, uint32(pJob - &_GeometryJobs[0]));
+			}, &Job, (Job.pMesh->pMeshData->GetClusterCount() == 0) ? "Triangles" : "Clusters");
 		}
 
 		TaskSystem::Instance().PushBarrier();
@@ -122,7 +390,12 @@ void Renderer::EndDraw()
 	// ・三角形のラスタライズをする
 	// ・ピクセルごとの深度テストをする
 	// ・ピクセルごとの法線とUVをとマテリアル情報をGBufferに書き込む
+	//  （可視バッファを使うときは三角形のセットアップ結果の番号だけを書き込む）
+	// ・深度とGBufferはタイルの作業用のバッファで読み書きして、最後に画面にまとめて書き出す
+	// タイルごとにシェーディングするときは、書き出さずに作業用のバッファからシェーディングまで行う
 	{
+		TaskSystem::Instance().SetPhaseName(_IsTileShadingEnabled ? "TileShade" : "Rasterize");
+
 		const int32 txCount = (SCREEN_WIDTH  + BUFFER_TILE_SIZE_X - 1) / BUFFER_TILE_SIZE_X;
 		const int32 tyCount = (SCREEN_HEIGHT + BUFFER_TILE_SIZE_Y - 1) / BUFFER_TILE_SIZE_Y;
 		for (int32 y = 0; y < tyCount; ++y)
@@ -142,17 +415,29 @@ void Renderer::EndDraw()
 				TaskSystem::Instance().PushQue([this](void* pData) {
 					PackedPosition Pos;
 					Pos.packed = (int64)pData;
-					RasterizeTile(Pos.x, Pos.y);
-				}, (void*)Position.packed);
+					if (_IsTileShadingEnabled)
+					{
+						RasterizeAndShadeTile(Pos.x, Pos.y);
+					}
+					else
+					{
+						RasterizeTileToScreen(Pos.x, Pos.y);
+					}
+				}, (void*)Position.packed, "Tile");
 			}
 		}
 
+		if (_IsTileShadingEnabled) return;
+
 		TaskSystem::Instance().PushBarrier();
 	}
 
 	// GBufferの内容をもとにシェーディングを行うジョブを作って並列処理をする
 	// ・ピクセルごとのマテリアル情報を元にテクスチャマッピングとライティングを行う
+	//  （可視バッファを使うときは見えている三角形の属性をここで補間する）
 	{
+		TaskSystem::Instance().SetPhaseName("Shading");
+
 		const int32 w = SCREEN_WIDTH;
 		const int32 h = 5;
 		const int32 yn = SCREEN_HEIGHT / h;
@@ -174,16 +459,250 @@ void Renderer::EndDraw()
 			TaskSystem::Instance().PushQue([this](void* pData) {
 				PackedRect Rc;
 				Rc.packed = (int64)pData;
-				DeferredShading(Rc.x, Rc.y, Rc.w, Rc.h);
-			}, (void*)Rect.packed);
+				if (_IsVisibilityBufferEnabled)
+				{
+					VisibilityShading(_ScreenTarget, Rc.x, Rc.y, Rc.w, Rc.h);
+				}
+				else
+				{
+					DeferredShading(_ScreenTarget, Rc.x, Rc.y, Rc.w, Rc.h);
+				}
+			}, (void*)Rect.packed, "Strip");
+		}
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void Renderer::ProcessGeometry(const GeometryJobData& Job, uint32 DrawNo)
+{
+	const auto& Mesh = *Job.pMesh;
+	const auto* pMeshData = Mesh.pMeshData;
+
+	// 遮蔽物に隠れているメッシュは何もしない
+	if (Job.IsOcclusionCulling && !_OcclusionBuffer.IsVisible(pMeshData->GetBoundingMin(), pMeshData->GetBoundingMax(), _mViewProj)) return;
+
+	auto& Dst = _RasterizeDatas[TaskSystem::GetCurrentCoreNo()];
+	if (pMeshData->GetClusterCount() == 0)
+	{
+		ProcessTriangles(Dst, DrawNo, Mesh, Job.Offset, Job.Count);
+	}
+	else
+	{
+		ProcessClusters(Dst, DrawNo, Mesh, Job.Offset, Job.Count, Job.IsOcclusionCulling);
+	}
+}
+
+//======================================================================================================
+// クラスタに分割していないメッシュの頂点を範囲ごとに変換して、メッシュで共有するバッファに書き込む
+//======================================================================================================
+void Renderer::ProcessVertices(const VertexJobData& Job)
+{
+	const auto& Mesh = *Job.pMesh;
+	const auto* pMeshData = Mesh.pMeshData;
+
+	// 隠れているメッシュは三角形の処理もしないので変換しなくてよい
+	if (Job.IsOcclusionCulling && !_OcclusionBuffer.IsVisible(pMeshData->GetBoundingMin(), pMeshData->GetBoundingMax(), _mViewProj)) return;
+
+	const auto Offset = Job.VertexOffset;
+	const auto Count = Job.VertexCount;
+	const auto VertexCount = pMeshData->GetVertexCount();
+
+	// SoAで持っていれば並べ替えずに読める
+	const auto* pPosSoA = pMeshData->GetPositionSoA();
+	if (pPosSoA != nullptr)
+	{
+		Matrix_Transform4x4Batch(Mesh.pPositions + Offset, pPosSoA + Offset, pPosSoA + VertexCount + Offset, pPosSoA + (VertexCount * 2) + Offset, nullptr, Count, _mViewProj);
+	}
+	else
+	{
+		Matrix_Transform4x4Batch(Mesh.pPositions + Offset, pMeshData->GetPosition() + Offset, nullptr, Count, _mViewProj);
+	}
+
+	const auto* pNormalSoA = pMeshData->GetNormalSoA();
+	if (pNormalSoA != nullptr)
+	{
+		Matrix_Transform3x3Batch(Mesh.pNormals + Offset, pNormalSoA + Offset, pNormalSoA + VertexCount + Offset, pNormalSoA + (VertexCount * 2) + Offset, nullptr, Count, Mesh.mWorld);
+	}
+	else
+	{
+		Matrix_Transform3x3Batch(Mesh.pNormals + Offset, pMeshData->GetNormal() + Offset, nullptr, Count, Mesh.mWorld);
+	}
+}
+
+//======================================================================================================
+// 変換済みの頂点を使って範囲内の三角形を処理する
+//======================================================================================================
+void Renderer::ProcessTriangles(RasterizeData& Dst, uint32 DrawNo, const RenderMeshData& Mesh, int32 TriangleOffset, int32 TriangleCount)
+{
+	const auto* pMeshData = Mesh.pMeshData;
+
+	// 三角形の番号はメッシュ全体を処理したときと同じにする
+	RenderTriangle(
+		Dst, DrawNo,
+		uint16(Mesh.TriangleId + TriangleOffset),
+		Mesh.TextureId,
+		pMeshData,
+		Mesh.pPositions,
+		Mesh.pNormals,
+		pMeshData->GetTexCoord(),
+		pMeshData->GetVertexCount(),
+		pMeshData->GetIndex() + (TriangleOffset * 3),
+		TriangleCount * 3);
+}
+
+//======================================================================================================
+// 見えないクラスタを捨ててから、残ったクラスタの頂点だけを変換して三角形を処理する
+//======================================================================================================
+void Renderer::ProcessClusters(RasterizeData& Dst, uint32 DrawNo, const RenderMeshData& Mesh, int32 ClusterOffset, int32 ClusterCount, bool IsOcclusionCulling)
+{
+	const auto* pMeshData = Mesh.pMeshData;
+	const auto* pClusters = pMeshData->GetCluster();
+	const auto* pClusterVertex = pMeshData->GetClusterVertex();
+	const auto* pClusterIndex = pMeshData->GetClusterIndex();
+	const auto* pClusterTriangle = pMeshData->GetClusterTriangle();
+	const auto* pPosTbl = pMeshData->GetPosition();
+	const auto* pNormalTbl = pMeshData->GetNormal();
+	const auto* pTexCoordTbl = pMeshData->GetTexCoord();
+	const auto* pPosSoA = pMeshData->GetPositionSoA();
+	const auto* pNormalSoA = pMeshData->GetNormalSoA();
+	const auto VertexCount = pMeshData->GetVertexCount();
+
+	const auto mWorld = Mesh.mWorld;
+	const auto mViewProj = _mViewProj;
+
+	Vector4 Positions[MESH_CLUSTER_VERTEX_COUNT];
+	Vector3 Normals[MESH_CLUSTER_VERTEX_COUNT];
+	Vector2 TexCoords[MESH_CLUSTER_VERTEX_COUNT];
+
+	for (int32 c = ClusterOffset; c < ClusterOffset + ClusterCount; ++c)
+	{
+		const auto& Cluster = pClusters[c];
+
+		// 視錐台の外か、すべての三角形が裏向きなら捨てる
+		if (!IsInFrustum(Cluster.Center, Cluster.Radius)) continue;
+		if (MeshCluster_IsBackFacing(Cluster, _CameraPosition)) continue;
+
+		// 遮蔽物に隠れているクラスタも捨てる
+		if (IsOcclusionCulling)
+		{
+			const Vector3 Extent = { Cluster.Radius, Cluster.Radius, Cluster.Radius };
+			Vector3 Min, Max;
+			Vector_Sub(Min, Cluster.Center, Extent);
+			Vector_Add(Max, Cluster.Center, Extent);
+			if (!_OcclusionBuffer.IsVisible(Min, Max, mViewProj)) continue;
+		}
+
+		const auto* pVertex = pClusterVertex + Cluster.VertexOffset;
+		if (pPosSoA != nullptr)
+		{
+			Matrix_Transform4x4Batch(Positions, pPosSoA, pPosSoA + VertexCount, pPosSoA + (VertexCount * 2), pVertex, Cluster.VertexCount, mViewProj);
+		}
+		else
+		{
+			Matrix_Transform4x4Batch(Positions, pPosTbl, pVertex, Cluster.VertexCount, mViewProj);
+		}
+		if (pNormalSoA != nullptr)
+		{
+			Matrix_Transform3x3Batch(Normals, pNormalSoA, pNormalSoA + VertexCount, pNormalSoA + (VertexCount * 2), pVertex, Cluster.VertexCount, mWorld);
+		}
+		else
+		{
+			Matrix_Transform3x3Batch(Normals, pNormalTbl, pVertex, Cluster.VertexCount, mWorld);
+		}
+		for (int32 i = 0; i < Cluster.VertexCount; ++i)
+		{
+			TexCoords[i] = pTexCoordTbl[pVertex[i]];
+		}
+
+		// 三角形の番号はメッシュ全体を処理したときと同じにする
+		for (int32 t = Cluster.TriangleOffset; t < Cluster.TriangleOffset + Cluster.TriangleCount; ++t)
+		{
+			RenderTriangle(
+				Dst, DrawNo,
+				uint16(Mesh.TriangleId + pClusterTriangle[t]),
+				Mesh.TextureId,
+				pMeshData,
+				Positions,
+				Normals,
+				TexCoords,
+				Cluster.VertexCount,
+				pClusterIndex + (t * 3),
+				3);
 		}
 	}
 }
 
+//======================================================================================================
+// ビュー・プロジェクション行列から視錐台の6平面を求める（法線は内向きで正規化する）
+//  -w <= x,y,z <= w の各面を、行列の列ベクトルの和と差で表す
+//======================================================================================================
+void Renderer::UpdateFrustumPlanes()
+{
+	const auto& m = _mViewProj;
+	const Vector4 cx = { m.x.x, m.y.x, m.z.x, m.w.x };
+	const Vector4 cy = { m.x.y, m.y.y, m.z.y, m.w.y };
+	const Vector4 cz = { m.x.z, m.y.z, m.z.z, m.w.z };
+	const Vector4 cw = { m.x.w, m.y.w, m.z.w, m.w.w };
+
+	Vector_Add(_FrustumPlanes[0], cw, cx);
+	Vector_Sub(_FrustumPlanes[1], cw, cx);
+	Vector_Add(_FrustumPlanes[2], cw, cy);
+	Vector_Sub(_FrustumPlanes[3], cw, cy);
+	Vector_Add(_FrustumPlanes[4], cw, cz);
+	Vector_Sub(_FrustumPlanes[5], cw, cz);
+
+	for (auto&& Plane : _FrustumPlanes)
+	{
+		const auto Length = sqrtf((Plane.x * Plane.x) + (Plane.y * Plane.y) + (Plane.z * Plane.z));
+		Vector_Mul(Plane, Plane, (Length > 0.0f) ? (1.0f / Length) : 0.0f);
+	}
+}
+
+//======================================================================================================
+// メッシュが視錐台にかかる可能性があるか
+//  先に境界球で判定して、残ったものはバウンディングボックスの一番内側の頂点で判定する
+//======================================================================================================
+bool Renderer::IsInFrustum(const IMeshData* pMeshData) const
+{
+	const auto& Center = pMeshData->GetBoundingCenter();
+	const auto Radius = pMeshData->GetBoundingRadius();
+	const auto& Min = pMeshData->GetBoundingMin();
+	const auto& Max = pMeshData->GetBoundingMax();
+
+	for (auto&& Plane : _FrustumPlanes)
+	{
+		const auto Distance = (Plane.x * Center.x) + (Plane.y * Center.y) + (Plane.z * Center.z) + Plane.w;
+		if (Distance < -Radius) return false;
+
+		const auto px = (Plane.x >= 0.0f) ? Max.x : Min.x;
+		const auto py = (Plane.y >= 0.0f) ? Max.y : Min.y;
+		const auto pz = (Plane.z >= 0.0f) ? Max.z : Min.z;
+		if ((Plane.x * px) + (Plane.y * py) + (Plane.z * pz) + Plane.w < 0.0f) return false;
+	}
+
+	return true;
+}
+
+//======================================================================================================
+// 球が視錐台にかかる可能性があるか
+//======================================================================================================
+bool Renderer::IsInFrustum(const Vector3& Center, fp32 Radius) const
+{
+	for (auto&& Plane : _FrustumPlanes)
+	{
+		const auto Distance = (Plane.x * Center.x) + (Plane.y * Center.y) + (Plane.z * Center.z) + Plane.w;
+		if (Distance < -Radius) return false;
+	}
+
+	return true;
+}
+
 //======================================================================================================
 //
 //======================================================================================================
-void Renderer::RenderTriangle(uint16 TriangleId, uint16_t TextureId, const IMeshData* pMeshData, const Vector4 Positions[], const Vector3 Normals[], const Vector2 Texcoord[], const int32 VertexCount, const uint16* pIndex, const int32 IndexCount)
+void Renderer::RenderTriangle(RasterizeData& Dst, uint32 DrawNo, uint16 TriangleId, uint16_t TextureId, const IMeshData* pMeshData, const Vector4 Positions[], const Vector3 Normals[], const Vector2 Texcoord[], const int32 VertexCount, const uint16* pIndex, const int32 IndexCount)
 {
 	static const uint8 index_table[8][8] = {
 		{ 0, 0, 0, 0, 0, 0, 0 },	// 0: -
@@ -196,9 +715,6 @@ void Renderer::RenderTriangle(uint16 TriangleId, uint16_t TextureId, const IMesh
 		{ 1, 2, 3, 4, 5, 6, 0 },	// 7: 0 1 2 3 4 5 6 0
 	};
 
-	const auto WidthF = SCREEN_WIDTH_F;
-	const auto HeightF = SCREEN_HEIGHT_F;
-
 	InternalVertex TempA[8], TempB[8];
 
 	auto index = 0;
@@ -208,9 +724,52 @@ void Renderer::RenderTriangle(uint16 TriangleId, uint16_t TextureId, const IMesh
 		const auto i1 = pIndex[index++];
 		const auto i2 = pIndex[index++];
 
-		TempA[0] = InternalVertex{ Positions[i0], Normals[i0], Texcoord[i0] };
-		TempA[1] = InternalVertex{ Positions[i1], Normals[i1], Texcoord[i1] };
-		TempA[2] = InternalVertex{ Positions[i2], Normals[i2], Texcoord[i2] };
+		// どれかの面の外側にすべての頂点があれば何もしない
+		// ガードバンドは面ではない（別々の方向にはみ出していても画面を覆うことがある）ので判定に使わない
+		const auto Code0 = GetClipCode(Positions[i0]);
+		const auto Code1 = GetClipCode(Positions[i1]);
+		const auto Code2 = GetClipCode(Positions[i2]);
+		if ((Code0 & Code1 & Code2 & ~CLIP_CODE_GUARD_BAND) != 0)
+		{
+			TriangleId++;
+			continue;
+		}
+
+		// ニアより手前かガードバンドの外に頂点がなければ切り取らずにそのまま使う
+		// ・画面からはみ出した部分はRasterizeTriangleでバウンディングボックスを画面に切り詰めて捨てる
+		// ・ファーより奥のピクセルは深度テスト（1.0でクリア）で消える
+		// 先に位置だけを投影して、塗らない三角形は法線やUVに触る前に捨てる
+		if (((Code0 | Code1 | Code2) & (CLIP_CODE_NEAR | CLIP_CODE_GUARD_BAND)) == 0)
+		{
+			const auto p0 = ProjectToScreen(Positions[i0]);
+			const auto p1 = ProjectToScreen(Positions[i1]);
+			const auto p2 = ProjectToScreen(Positions[i2]);
+			TrianglePlanes Planes;
+			if (IsTriangleRasterizable(p0, p1, p2) &&
+				MakeTrianglePlanes(Planes, Positions[i0], Positions[i1], Positions[i2], Texcoord[i0], Texcoord[i1], Texcoord[i2]))
+			{
+				RasterizeTriangle(
+					Dst, DrawNo, TriangleId, TextureId, Planes,
+					InternalVertex{ p0, Normals[i0] },
+					InternalVertex{ p1, Normals[i1] },
+					InternalVertex{ p2, Normals[i2] });
+			}
+
+			TriangleId++;
+			continue;
+		}
+
+		// 切り取った三角形も元の三角形の平面の式で補間する
+		TrianglePlanes Planes;
+		if (!MakeTrianglePlanes(Planes, Positions[i0], Positions[i1], Positions[i2], Texcoord[i0], Texcoord[i1], Texcoord[i2]))
+		{
+			TriangleId++;
+			continue;
+		}
+
+		TempA[0] = InternalVertex{ Positions[i0], Normals[i0] };
+		TempA[1] = InternalVertex{ Positions[i1], Normals[i1] };
+		TempA[2] = InternalVertex{ Positions[i2], Normals[i2] };
 		int32 PointCount = 3;
 
 		PointCount = ClipPoints(TempB, TempA, PointCount, [](const Vector4& v) { return v.w - v.y; });
@@ -223,15 +782,7 @@ void Renderer::RenderTriangle(uint16 TriangleId, uint16_t TextureId, const IMesh
 		for (int32 j = 0; j < PointCount; ++j)
 		{
 			auto& pt = TempA[j];
-			auto invW = 1.0f / pt.Position.w;
-			auto screen_x = (+pt.Position.x * invW * 0.5f + 0.5f) * WidthF;
-			auto screen_y = (-pt.Position.y * invW * 0.5f + 0.5f) * HeightF;
-			pt.Position.x = floorf(screen_x * 16.0f) / 16.0f;
-			pt.Position.y = floorf(screen_y * 16.0f) / 16.0f;
-			pt.Position.w = invW;
-			pt.Position.z *= invW;
-			pt.TexCoord.x *= invW;
-			pt.TexCoord.y *= invW;
+			pt.Position = ProjectToScreen(pt.Position);
 		}
 
 		auto table = index_table[PointCount];
@@ -240,7 +791,8 @@ void Renderer::RenderTriangle(uint16 TriangleId, uint16_t TextureId, const IMesh
 		{
 			auto& cv1 = TempA[j];
 			auto& cv2 = TempA[table[j]];	// [(i + 1) % PointCount]
-			RasterizeTriangle(TriangleId, TextureId, cv0, cv1, cv2);
+			if (!IsTriangleRasterizable(cv0.Position, cv1.Position, cv2.Position)) continue;
+			RasterizeTriangle(Dst, DrawNo, TriangleId, TextureId, Planes, cv0, cv1, cv2);
 		}
 
 		TriangleId++;
@@ -250,7 +802,7 @@ void Renderer::RenderTriangle(uint16 TriangleId, uint16_t TextureId, const IMesh
 //======================================================================================================
 //
 //======================================================================================================
-void Renderer::RasterizeTriangle(uint16 TriangleId, uint16 TextureId, InternalVertex v0, InternalVertex v1, InternalVertex v2)
+void Renderer::RasterizeTriangle(RasterizeData& Dst, uint32 DrawNo, uint16 TriangleId, uint16 TextureId, const TrianglePlanes& Planes, InternalVertex v0, InternalVertex v1, InternalVertex v2)
 {
 	// 三角形の各位置
 	auto& p0 = v0.Position;
@@ -258,27 +810,8 @@ void Renderer::RasterizeTriangle(uint16 TriangleId, uint16 TextureId, InternalVe
 	auto& p2 = v2.Position;
 
 	// 外積から面の向きを求めて、裏向きなら破棄する（backface-culling)
-	const auto Denom = ((p1.x - p0.x) * (p2.y - p0.y)) - ((p1.y - p0.y) * (p2.x - p0.x));
-	if (Denom <= 0.0f) return;
-
-	// 補間処理の事前計算
-	auto& t0 = v0.TexCoord;
-	auto& t1 = v1.TexCoord;
-	auto& t2 = v2.TexCoord;
-
-	const auto InvDenom = 1.0f / Denom;
-	p0.z *= InvDenom;
-	p1.z *= InvDenom;
-	p2.z *= InvDenom;
-	p0.w *= InvDenom;
-	p1.w *= InvDenom;
-	p2.w *= InvDenom;
-	t0.x *= InvDenom;
-	t0.y *= InvDenom;
-	t1.x *= InvDenom;
-	t1.y *= InvDenom;
-	t2.x *= InvDenom;
-	t2.y *= InvDenom;
+	const auto FixedDenom = GetFixedDenom(p0, p1, p2);
+	if (FixedDenom <= 0) return;
 
 	auto bbMinX = p0.x, bbMinY = p0.y, bbMaxX = p0.x, bbMaxY = p0.y;
 	if (bbMaxX < p1.x) bbMaxX = p1.x;
@@ -290,11 +823,97 @@ void Renderer::RasterizeTriangle(uint16 TriangleId, uint16 TextureId, InternalVe
 	if (bbMinY > p1.y) bbMinY = p1.y;
 	if (bbMinY > p2.y) bbMinY = p2.y;
 
+	// 切り取らずに画面からはみ出している三角形はここで画面に切り詰める
+	bbMinX = std::max(bbMinX, 0.0f);
+	bbMinY = std::max(bbMinY, 0.0f);
+	bbMaxX = std::min(bbMaxX, SCREEN_WIDTH_F);
+	bbMaxY = std::min(bbMaxY, SCREEN_HEIGHT_F);
+	if ((bbMinX > bbMaxX) || (bbMinY > bbMaxY)) return;
+
 	const auto x0 = int16(bbMinX);
 	const auto x1 = int16(bbMaxX);
 	const auto y0 = int16(bbMinY);
 	const auto y1 = int16(bbMaxY);
 
+	// セットアップ結果は1回だけ書き込んで、タイルにはインデックスだけを積む
+	uint32 SetupIndex;
+	auto* pSetup = AllocateSetup(Dst, SetupIndex);
+	if (pSetup == nullptr)
+	{
+		_DroppedTriangleCount.Increment();
+		return;
+	}
+
+	// ピクセルの内外の判定に使う辺の式は28.4の固定小数点の整数にする
+	const auto MakeEdge = [](const Vector4& pi, const Vector4& pj, int64 c)
+	{
+		const auto a = ToFixed(pi.y) - ToFixed(pj.y);
+		const auto b = ToFixed(pj.x) - ToFixed(pi.x);
+		return RasterizeEdge{ a, b, int32(IsTopLeftEdge(a, b) ? c : (c - 1)) };
+	};
+
+	auto& Setup = *pSetup;
+	Setup.OriginX = fp32(x0);
+	Setup.OriginY = fp32(y0);
+	Setup.FixedOriginX = ToFixed(p0.x);
+	Setup.FixedOriginY = ToFixed(p0.y);
+	Setup.Edge[0] = MakeEdge(p1, p2, FixedDenom);
+	Setup.Edge[1] = MakeEdge(p2, p0, 0);
+	Setup.Edge[2] = MakeEdge(p0, p1, 0);
+
+	// 深度、1/w、テクスチャ座標は切り取る前の三角形から求めた平面の式を使う
+	//  切り取った三角形は頂点を1/16ピクセルに丸めてから属性を補間しなおすと元の三角形と結果が変わるので、
+	//  切り取ったかどうかによらず同じ式を使う
+	// 原点は画面の中のバウンディングボックスの左上に移してからfp32にする
+	//  （頂点を原点にすると画面の外の遠い頂点のときに桁落ちする）
+	const auto ox = fp64(x0);
+	const auto oy = fp64(y0);
+	const auto Rebase = [&](const ScreenPlane& Plane)
+	{
+		return RasterizePlane{ fp32(Plane.a), fp32(Plane.b), fp32((Plane.a * ox) + (Plane.b * oy) + Plane.c) };
+	};
+	const auto Evaluate = [](const ScreenPlane& Plane, const Vector4& p)
+	{
+		return fp32((Plane.a * fp64(p.x)) + (Plane.b * fp64(p.y)) + Plane.c);
+	};
+
+	// 法線は重心座標 b1 = (p0 - p2) × (p - p2)、b2 = (p1 - p0) × (p - p0) をDenomで割って
+	//  a0 + (a1 - a0) * b1 / Denom + (a2 - a0) * b2 / Denom で線形に補間するので、平面の式にまとめる
+	// 画面座標は1/16ピクセルに丸めてあるので、辺の係数とDenomはfp64で誤差なく求まる
+	const auto InvDenom = 256.0 / fp64(FixedDenom);
+	const auto b1a = fp64(p2.y) - fp64(p0.y), b1b = fp64(p0.x) - fp64(p2.x);
+	const auto b2a = fp64(p0.y) - fp64(p1.y), b2b = fp64(p1.x) - fp64(p0.x);
+	const auto dx = ox - fp64(p0.x);
+	const auto dy = oy - fp64(p0.y);
+	const auto MakePlane = [&](fp32 a0, fp32 a1, fp32 a2)
+	{
+		const auto d1 = (fp64(a1) - fp64(a0)) * InvDenom;
+		const auto d2 = (fp64(a2) - fp64(a0)) * InvDenom;
+		const auto a = (b1a * d1) + (b2a * d2);
+		const auto b = (b1b * d1) + (b2b * d2);
+		return RasterizePlane{ fp32(a), fp32(b), fp32(fp64(a0) + (a * dx) + (b * dy)) };
+	};
+
+	auto& n0 = v0.Normal;
+	auto& n1 = v1.Normal;
+	auto& n2 = v2.Normal;
+
+	Setup.Depth			= Rebase(Planes.Depth);
+	Setup.InvW			= Rebase(Planes.InvW);
+	Setup.Normal[0]		= MakePlane(n0.x, n1.x, n2.x);
+	Setup.Normal[1]		= MakePlane(n0.y, n1.y, n2.y);
+	Setup.Normal[2]		= MakePlane(n0.z, n1.z, n2.z);
+	Setup.TexCoord[0]	= Rebase(Planes.TexCoord[0]);
+	Setup.TexCoord[1]	= Rebase(Planes.TexCoord[1]);
+	Setup.MinZ			= std::min(Evaluate(Planes.Depth, p0), std::min(Evaluate(Planes.Depth, p1), Evaluate(Planes.Depth, p2)));
+	Setup.bbMinX		= x0;
+	Setup.bbMinY		= y0;
+	Setup.bbMaxX		= x1;
+	Setup.bbMaxY		= y1;
+	Setup.TriangleId	= TriangleId;
+	Setup.TextureId		= TextureId;
+	Setup.DrawNo		= DrawNo;
+
 	const auto tx0 = x0 / BUFFER_TILE_SIZE_X;
 	const auto tx1 = std::min(x1 / BUFFER_TILE_SIZE_X, MAX_TILE_COUNT_X - 1);
 	const auto ty0 = y0 / BUFFER_TILE_SIZE_Y;
@@ -304,173 +923,697 @@ void Renderer::RasterizeTriangle(uint16 TriangleId, uint16 TextureId, InternalVe
 	{
 		for (auto tx = tx0; tx <= tx1; ++tx)
 		{
-			PushTriangleToTile(
-				tx, ty,
-				bbMinX, bbMinY, bbMaxX, bbMaxY,
-				InvDenom,
-				TriangleId, TextureId,
-				v0, v1, v2);
+			PushTriangleToTile(Dst, tx, ty, SetupIndex);
 		}
 	}
 }
 
 //======================================================================================================
-//
+// 三角形のセットアップ結果1つ分の場所を確保する
+//  スレッドごとにブロック単位でまとめて確保して、インデックスの上位がブロック番号、下位がブロック内の位置
 //======================================================================================================
-void Renderer::PushTriangleToTile(
-	int32 tx, int32 ty,
-	fp32 bbMinX, fp32 bbMinY, fp32 bbMaxX, fp32 bbMaxY, fp32 InvDenom,
-	uint16 TriangleId, uint16 TextureId, InternalVertex v0, InternalVertex v1, InternalVertex v2)
+RasterizeSetupData* Renderer::AllocateSetup(RasterizeData& Dst, uint32& SetupIndex)
 {
-	const auto minTileX = tx * BUFFER_TILE_SIZE_X;
-	const auto minTileY = ty * BUFFER_TILE_SIZE_Y;
-	const auto maxTileX = minTileX + BUFFER_TILE_SIZE_X - 1;
-	const auto maxTileY = minTileY + BUFFER_TILE_SIZE_Y - 1;
+	if (Dst.SetupCount == RASTERIZE_SETUP_BLOCK)
+	{
+		const auto BlockNo = _SetupBlockCount.Increment() - 1;
+		if (BlockNo >= int32(_SetupBlocks.size())) return nullptr;
+
+		auto* pMemory = _RasterizeArena.Allocate(sizeof(RasterizeSetupBlock));
+		if (pMemory == nullptr) return nullptr;
+
+		_SetupBlocks[BlockNo] = reinterpret_cast<RasterizeSetupBlock*>(pMemory);
+		Dst.SetupBlockNo = BlockNo;
+		Dst.SetupCount = 0;
+	}
+
+	const auto Index = Dst.SetupCount++;
+	SetupIndex = (uint32(Dst.SetupBlockNo) * RASTERIZE_SETUP_BLOCK) + uint32(Index);
+	return &_SetupBlocks[Dst.SetupBlockNo]->Setups[Index];
+}
+
+//======================================================================================================
+// タイルの入れ物にインデックス1つ分の場所を確保する
+//  最後のチャンクが埋まっていたら新しいチャンクを後ろにつなぐ
+//======================================================================================================
+uint32* Renderer::AllocateBinEntry(RasterizeBin& Bin)
+{
+	auto* pChunk = Bin.pTail;
+	if ((pChunk == nullptr) || (pChunk->Count == RASTERIZE_CHUNK_SIZE))
+	{
+		auto* pMemory = _RasterizeArena.Allocate(sizeof(RasterizeChunk));
+		if (pMemory == nullptr) return nullptr;
+
+		auto* pNewChunk = new (pMemory) RasterizeChunk;
+		pNewChunk->pNext = nullptr;
+		pNewChunk->Count = 0;
+		if (pChunk != nullptr)
+		{
+			pChunk->pNext = pNewChunk;
+		}
+		else
+		{
+			Bin.pHead = pNewChunk;
+		}
+		Bin.pTail = pChunk = pNewChunk;
+	}
 
-	auto& Dst = _RasterizeDatas[ty][tx];
-	auto& Tri = Dst.Triangles[Dst.Count.Increment() - 1];
-	Tri.bbMinX		= std::max(int16(bbMinX), int16(minTileX));
-	Tri.bbMinY		= std::max(int16(bbMinY), int16(minTileY));
-	Tri.bbMaxX		= std::min(int16(bbMaxX), int16(maxTileX));
-	Tri.bbMaxY		= std::min(int16(bbMaxY), int16(maxTileY));
-	Tri.TriangleId	= TriangleId;
-	Tri.TextureId	= TextureId;
-	Tri.InvDenom	= InvDenom;
-	Tri.v0			= v0;
-	Tri.v1			= v1;
-	Tri.v2			= v2;
+	return &pChunk->SetupIndices[pChunk->Count++];
 }
 
 //======================================================================================================
 //
 //======================================================================================================
-void Renderer::RasterizeTile(int32 tx, int32 ty)
+void Renderer::PushTriangleToTile(RasterizeData& Dst, int32 tx, int32 ty, uint32 SetupIndex)
 {
-	auto& Src = _RasterizeDatas[ty][tx];
-	const int32_t Count = Src.Count.Load();
+	auto* pEntry = AllocateBinEntry(Dst.Bins[ty][tx]);
+	if (pEntry == nullptr)
+	{
+		_DroppedTriangleCount.Increment();
+		return;
+	}
+
+	*pEntry = SetupIndex;
+}
 
-	for (int32 i = 0; i < Count; ++i)
+//======================================================================================================
+// タイルに積まれた三角形をタイルの作業用のバッファTargetに描画する（三角形が1つもなければfalseを返す）
+//======================================================================================================
+bool Renderer::RasterizeTile(int32 tx, int32 ty, const RasterizeTarget& Target)
+{
+	// スレッドごとの入れ物には実行したメッシュの順に積まれているので
+	// DrawNoが小さいものから順にメッシュ単位で取り出して、シングルスレッドと同じ順番で描画する
+	struct Cursor
 	{
-		const auto& Tri = Src.Triangles[i];
+		const RasterizeChunk*	pChunk;
+		int32					Index;
+		uint32					DrawNo;
+	};
 
-		const auto p0 = Tri.v0.Position;
-		const auto p1 = Tri.v1.Position;
-		const auto p2 = Tri.v2.Position;
-		const auto n0 = Tri.v0.Normal;
-		const auto n1 = Tri.v1.Normal;
-		const auto n2 = Tri.v2.Normal;
-		const auto t0 = Tri.v0.TexCoord;
-		const auto t1 = Tri.v1.TexCoord;
-		const auto t2 = Tri.v2.TexCoord;
+	const auto UpdateDrawNo = [this](Cursor& Cur)
+	{
+		if (Cur.pChunk != nullptr)
+		{
+			Cur.DrawNo = GetSetup(Cur.pChunk->SetupIndices[Cur.Index]).DrawNo;
+		}
+	};
 
-		const auto InvDenom		= Tri.InvDenom;
-		const auto TextureId	= Tri.TextureId;
-		const auto TriangleId	= Tri.TriangleId;
+	const int32 WorkerCount = int32(_RasterizeDatas.size());
+	thread_local static std::vector<Cursor> Cursors;
+	Cursors.resize(WorkerCount);
+	bool IsEmpty = true;
+	for (int32 i = 0; i < WorkerCount; ++i)
+	{
+		auto& Bin = _RasterizeDatas[i].Bins[ty][tx];
+		Cursors[i].pChunk = Bin.pHead;
+		Cursors[i].Index = 0;
+		UpdateDrawNo(Cursors[i]);
+		IsEmpty &= (Bin.pHead == nullptr);
+		Bin.pHead = nullptr;
+		Bin.pTail = nullptr;
+	}
 
-		const auto x0 = Tri.bbMinX;
-		const auto x1 = Tri.bbMaxX;
-		const auto y0 = Tri.bbMinY;
-		const auto y1 = Tri.bbMaxY;
+	const int32 minTileX = tx * BUFFER_TILE_SIZE_X;
+	const int32 minTileY = ty * BUFFER_TILE_SIZE_Y;
+	const int32 maxTileX = minTileX + BUFFER_TILE_SIZE_X - 1;
+	const int32 maxTileY = minTileY + BUFFER_TILE_SIZE_Y - 1;
 
-		const auto beign_x = fp32(x0) + 0.5f;
-		const auto beign_y = fp32(y0) + 0.5f;
+	if (IsEmpty) return false;
 
-		const auto p2_p1_x = p2.x - p1.x;
-		const auto p2_p1_y = p2.y - p1.y;
-		const auto p0_p2_x = p0.x - p2.x;
-		const auto p0_p2_y = p0.y - p2.y;
-		const auto p1_p0_x = p1.x - p0.x;
-		const auto p1_p0_y = p1.y - p0.y;
+	// 作業用のバッファを画面のバッファと同じクリアした値から始める
+	//  何も描かれなかったピクセルが空のタイル（ClearTile）と同じ値になる
+	const auto ClearDepth = _pDepthBuffer->GetClearValue();
+	const auto ClearGBuffer = _pGBuffer->GetClearValue();
+	ASSERT(ClearGBuffer.TextureId == INVALID_TEXTURE_ID);
+	for (auto y = minTileY; y <= maxTileY; ++y)
+	{
+		const auto Offset = Target.GetOffset(minTileX, y);
+		std::fill_n(Target.pDepth + Offset, BUFFER_TILE_SIZE_X, ClearDepth);
+		if (Target.pVisibility != nullptr)
+		{
+			std::fill_n(Target.pVisibility + Offset, BUFFER_TILE_SIZE_X, INVALID_VISIBILITY_ID);
+		}
+		else
+		{
+			std::fill_n(Target.pGBuffer + Offset, BUFFER_TILE_SIZE_X, ClearGBuffer);
+		}
+	}
 
-		auto b0_row = (p2_p1_x * (beign_y - p1.y)) - (p2_p1_y * (beign_x - p1.x));
-		auto b1_row = (p0_p2_x * (beign_y - p2.y)) - (p0_p2_y * (beign_x - p2.x));
-		auto b2_row = (p1_p0_x * (beign_y - p0.y)) - (p1_p0_y * (beign_x - p0.x));
+	// 深度はすべてクリアした値なので階層Zもその値から始める
+	RasterizeHiZ HiZ;
+	HiZ.OriginX = minTileX;
+	HiZ.OriginY = minTileY;
+	std::fill_n(&HiZ.BlockMaxZ[0][0], TILE_BLOCK_COUNT_X * TILE_BLOCK_COUNT_Y, ClearDepth);
+	HiZ.IsTileDirty = true;
 
-		auto pDepthBuffer = _pDepthBuffer->GetPixelPointer(0, y0);
-		auto pGBuffer = _pGBuffer->GetPixelPointer(0, y0);
+	for (;;)
+	{
+		Cursor* pCursor = nullptr;
+		for (auto&& Cur : Cursors)
+		{
+			if (Cur.pChunk == nullptr) continue;
+			if ((pCursor == nullptr) || (Cur.DrawNo < pCursor->DrawNo))
+			{
+				pCursor = &Cur;
+			}
+		}
+		if (pCursor == nullptr) break;
 
-		for (auto y = y0; y <= y1; ++y)
+		const auto DrawNo = pCursor->DrawNo;
+		do
 		{
-			auto bRasterized = false;
+			const auto SetupIndex = pCursor->pChunk->SetupIndices[pCursor->Index];
+			const auto& Setup = GetSetup(SetupIndex);
 
-			auto b0 = b0_row;
-			auto b1 = b1_row;
-			auto b2 = b2_row;
+			if (HiZ.IsTileDirty)
+			{
+				HiZ.TileMaxZ = HiZ.BlockMaxZ[0][0];
+				for (auto&& Row : HiZ.BlockMaxZ)
+				{
+					for (auto MaxZ : Row)
+					{
+						HiZ.TileMaxZ = std::max(HiZ.TileMaxZ, MaxZ);
+					}
+				}
+				HiZ.IsTileDirty = false;
+			}
 
-			for (auto x = x0; x <= x1; ++x, b0 -= p2_p1_y, b1 -= p0_p2_y, b2 -= p1_p0_y)
+			// タイルのどこよりも奥にある三角形は深度テストに通らない
+			if (Setup.MinZ < HiZ.TileMaxZ)
 			{
-				if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f) if (bRasterized) break; else continue;
-
-				bRasterized = true;
-
-				const auto z = (b0 * p0.z) + (b1 * p1.z) + (b2 * p2.z);
-				auto& DepthBuf = pDepthBuffer[x];
-				if (DepthBuf <= z) continue;
-				DepthBuf = z;
-
-				const auto w = 1.0f / ((b0 * p0.w) + (b1 * p1.w) + (b2 * p2.w));
-				auto& GBuff = pGBuffer[x];
-				GBuff.TextureId  = TextureId;
-				GBuff.TriangleId = TriangleId;
-				GBuff.Normal.x   = (b0 * n0.x) + (b1 * n1.x) + (b2 * n2.x);
-				GBuff.Normal.y   = (b0 * n0.y) + (b1 * n1.y) + (b2 * n2.y);
-				GBuff.Normal.z   = (b0 * n0.z) + (b1 * n1.z) + (b2 * n2.z);
-				GBuff.TexCoord.x = (b0 * t0.x) + (b1 * t1.x) + (b2 * t2.x);
-				GBuff.TexCoord.y = (b0 * t0.y) + (b1 * t1.y) + (b2 * t2.y);
-				GBuff.TexCoord.x *= w;
-				GBuff.TexCoord.y *= w;
+				RasterizeTileTriangle(
+					Setup,
+					SetupIndex,
+					HiZ,
+					Target,
+					std::max(int32(Setup.bbMinX), minTileX),
+					std::max(int32(Setup.bbMinY), minTileY),
+					std::min(int32(Setup.bbMaxX), maxTileX),
+					std::min(int32(Setup.bbMaxY), maxTileY));
 			}
 
-			b0_row += p2_p1_x;
-			b1_row += p0_p2_x;
-			b2_row += p1_p0_x;
+			if (++pCursor->Index == pCursor->pChunk->Count)
+			{
+				pCursor->pChunk = pCursor->pChunk->pNext;
+				pCursor->Index = 0;
+			}
+			UpdateDrawNo(*pCursor);
+		}
+		while ((pCursor->pChunk != nullptr) && (pCursor->DrawNo == DrawNo));
+	}
+
+	return true;
+}
 
-			pDepthBuffer += SCREEN_WIDTH;
-			pGBuffer += SCREEN_WIDTH;
+//======================================================================================================
+// タイルの作業用のバッファを書き込み先にする
+//  クリアは三角形があるときだけRasterizeTileで行う
+//======================================================================================================
+RasterizeTarget Renderer::GetTileTarget(int32 tx, int32 ty) const
+{
+	thread_local static RasterizeTileBuffer Buffer;
+
+	RasterizeTarget Target;
+	Target.OriginX		= tx * BUFFER_TILE_SIZE_X;
+	Target.OriginY		= ty * BUFFER_TILE_SIZE_Y;
+	Target.Pitch		= BUFFER_TILE_SIZE_X;
+	Target.pDepth		= &Buffer.Depth[0][0];
+	Target.pGBuffer		= &Buffer.GBuffer[0][0];
+	Target.pVisibility	= _IsVisibilityBufferEnabled ? &Buffer.Visibility[0][0] : nullptr;
+	return Target;
+}
+
+//======================================================================================================
+// タイルを作業用のバッファにラスタライズして、画面の深度とGBufferに1度だけ書き出す
+//======================================================================================================
+void Renderer::RasterizeTileToScreen(int32 tx, int32 ty)
+{
+	const auto Target = GetTileTarget(tx, ty);
+	const int32 Width = std::min(BUFFER_TILE_SIZE_X, SCREEN_WIDTH - Target.OriginX);
+	const int32 Height = std::min(BUFFER_TILE_SIZE_Y, SCREEN_HEIGHT - Target.OriginY);
+
+	// 画面のバッファはフレームの最初にクリアしないので、三角形がなければタイルをクリアする
+	// 前のフレームでもクリアしたままのタイルには書き込まない
+	_IsTileEmpty[ty][tx] = !RasterizeTile(tx, ty, Target);
+	if (_IsTileEmpty[ty][tx])
+	{
+		_pColorBuffer->ClearTile(tx, ty);
+		_pDepthBuffer->ClearTile(tx, ty);
+		if (_ScreenTarget.pVisibility != nullptr)
+		{
+			_VisibilityBuffer.ClearTile(tx, ty);
+		}
+		else
+		{
+			_pGBuffer->ClearTile(tx, ty);
 		}
+		return;
 	}
 
-	Src.Count = 0;
+	// 三角形があればタイル全体を作業用のバッファで上書きして、色はシェーディングですべて書き込む
+	_pColorBuffer->SetTileDirty(tx, ty);
+	_pDepthBuffer->SetTileDirty(tx, ty);
+	if (_ScreenTarget.pVisibility != nullptr)
+	{
+		_VisibilityBuffer.SetTileDirty(tx, ty);
+	}
+	else
+	{
+		_pGBuffer->SetTileDirty(tx, ty);
+	}
+	for (int32 y = 0; y < Height; ++y)
+	{
+		const auto Src = Target.GetOffset(Target.OriginX, Target.OriginY + y);
+		const auto Dst = _ScreenTarget.GetOffset(Target.OriginX, Target.OriginY + y);
+		memcpy(_ScreenTarget.pDepth + Dst, Target.pDepth + Src, sizeof(fp32) * Width);
+		if (_ScreenTarget.pVisibility != nullptr)
+		{
+			memcpy(_ScreenTarget.pVisibility + Dst, Target.pVisibility + Src, sizeof(uint32) * Width);
+		}
+		else
+		{
+			memcpy(_ScreenTarget.pGBuffer + Dst, Target.pGBuffer + Src, sizeof(GBufferData) * Width);
+		}
+	}
+}
+
+//======================================================================================================
+// タイルのラスタライズとシェーディングを続けて行う
+//  GBufferは作業用のバッファからそのままシェーディングで読み、画面には色だけを書き出す
+//  深度は出力を有効にしたときだけ書き出す（書き出さないタイルはクリア済みかどうかの状態も変えない）
+//======================================================================================================
+void Renderer::RasterizeAndShadeTile(int32 tx, int32 ty)
+{
+	const auto Target = GetTileTarget(tx, ty);
+	const int32 Width = std::min(BUFFER_TILE_SIZE_X, SCREEN_WIDTH - Target.OriginX);
+	const int32 Height = std::min(BUFFER_TILE_SIZE_Y, SCREEN_HEIGHT - Target.OriginY);
+
+	// 三角形がなければ色のタイルをクリアする
+	_IsTileEmpty[ty][tx] = !RasterizeTile(tx, ty, Target);
+	if (_IsTileEmpty[ty][tx])
+	{
+		_pColorBuffer->ClearTile(tx, ty);
+		if (_IsDepthOutputEnabled)
+		{
+			_pDepthBuffer->ClearTile(tx, ty);
+		}
+		return;
+	}
+
+	_pColorBuffer->SetTileDirty(tx, ty);
+	if (_IsDepthOutputEnabled)
+	{
+		_pDepthBuffer->SetTileDirty(tx, ty);
+		for (int32 y = 0; y < Height; ++y)
+		{
+			const auto Src = Target.GetOffset(Target.OriginX, Target.OriginY + y);
+			const auto Dst = _ScreenTarget.GetOffset(Target.OriginX, Target.OriginY + y);
+			memcpy(_ScreenTarget.pDepth + Dst, Target.pDepth + Src, sizeof(fp32) * Width);
+		}
+	}
+
+	if (_IsVisibilityBufferEnabled)
+	{
+		VisibilityShading(Target, Target.OriginX, Target.OriginY, Width, Height);
+	}
+	else
+	{
+		DeferredShading(Target, Target.OriginX, Target.OriginY, Width, Height);
+	}
 }
 
 //======================================================================================================
 //
 //======================================================================================================
-void Renderer::DeferredShading(int32 x, int32 y, int32 w, int32 h)
+void Renderer::RasterizeTileTriangle(const RasterizeSetupData& Setup, uint32 SetupIndex, RasterizeHiZ& HiZ, const RasterizeTarget& Target, int32 x0, int32 y0, int32 x1, int32 y1)
+{
+	const auto& e0 = Setup.Edge[0];
+	const auto& e1 = Setup.Edge[1];
+	const auto& e2 = Setup.Edge[2];
+	const auto& pz = Setup.Depth;
+	const auto& pw = Setup.InvW;
+	const auto& nx = Setup.Normal[0];
+	const auto& ny = Setup.Normal[1];
+	const auto& nz = Setup.Normal[2];
+	const auto& tu = Setup.TexCoord[0];
+	const auto& tv = Setup.TexCoord[1];
+
+	const auto TextureId	= Setup.TextureId;
+	const auto TriangleId	= Setup.TriangleId;
+	const auto IsVisibility	= (Target.pVisibility != nullptr);
+
+	const auto Ramp = SIMD_Ramp();
+	const auto MinX = SIMD_Set(fp32(x0));
+	const auto MaxX = SIMD_Set(fp32(x1));
+	const auto Zero = SIMD_Set(0.0f);
+	const auto One = SIMD_Set(1.0f);
+	const auto MinusOne = SIMD_SetInt(-1);
+	const auto Sign = [&](fp32x8 v) { return SIMD_Select(SIMD_CmpGE(v, Zero), One, SIMD_Set(-1.0f)); };
+
+	// 辺の式は1ピクセル右に進むとa、下に進むとbの16倍だけ変わる
+	const auto StepX0 = SIMD_RampInt(e0.a * 16);
+	const auto StepX1 = SIMD_RampInt(e1.a * 16);
+	const auto StepX2 = SIMD_RampInt(e2.a * 16);
+	const auto StepY0 = e0.b * 16;
+	const auto StepY1 = e1.b * 16;
+	const auto StepY2 = e2.b * 16;
+
+	int32 Normal[2][SIMD_WIDTH], TexCoord[2][SIMD_WIDTH];
+
+	// ピクセル中心の28.4の固定小数点の座標（辺の式の原点から）
+	const auto FixedX = [&](int32 x) { return (x * 16) + 8 - Setup.FixedOriginX; };
+	const auto FixedY = [&](int32 y) { return (y * 16) + 8 - Setup.FixedOriginY; };
+
+	// 辺の式の矩形内での最小値と最大値（ピクセル中心の四隅のどれかで決まる）
+	const auto EdgeRange = [](const RasterizeEdge& e, int32 ix0, int32 iy0, int32 ix1, int32 iy1, int64& Min, int64& Max)
+	{
+		const auto ax0 = int64(e.a) * ix0;
+		const auto ax1 = int64(e.a) * ix1;
+		const auto by0 = (int64(e.b) * iy0) + e.c;
+		const auto by1 = (int64(e.b) * iy1) + e.c;
+		Min = std::min(ax0, ax1) + std::min(by0, by1);
+		Max = std::max(ax0, ax1) + std::max(by0, by1);
+	};
+
+	// 平面の式の矩形内での最小値と最大値
+	const auto PlaneRange = [](const RasterizePlane& e, fp32 fx0, fp32 fy0, fp32 fx1, fp32 fy1, fp32& Min, fp32& Max)
+	{
+		const auto ax0 = e.a * fx0;
+		const auto ax1 = e.a * fx1;
+		const auto by0 = (e.b * fy0) + e.c;
+		const auto by1 = (e.b * fy1) + e.c;
+		Min = std::min(ax0, ax1) + std::min(by0, by1);
+		Max = std::max(ax0, ax1) + std::max(by0, by1);
+	};
+
+	// 横にSIMD_WIDTHピクセルずつ、タイルの左上からRASTERIZE_BLOCK_SIZE四方に区切ったブロック単位で処理する
+	// ブロックの左端はSIMD_WIDTHの倍数で、タイルの幅もSIMD_WIDTHの倍数なので
+	// 範囲外のピクセルもタイル内で他のスレッドが触ることはない
+	static_assert(RASTERIZE_BLOCK_SIZE == SIMD_WIDTH, "ブロックの1行を1回のSIMDで処理する");
+	static_assert((BUFFER_TILE_SIZE_X % RASTERIZE_BLOCK_SIZE) == 0, "タイルの幅はブロックの倍数にする");
+	const auto BlockX0 = (x0 - HiZ.OriginX) / RASTERIZE_BLOCK_SIZE;
+	const auto BlockX1 = (x1 - HiZ.OriginX) / RASTERIZE_BLOCK_SIZE;
+	const auto BlockY0 = (y0 - HiZ.OriginY) / RASTERIZE_BLOCK_SIZE;
+	const auto BlockY1 = (y1 - HiZ.OriginY) / RASTERIZE_BLOCK_SIZE;
+
+	for (auto BlockY = BlockY0; BlockY <= BlockY1; ++BlockY)
+	{
+		const auto by = std::max(HiZ.OriginY + (BlockY * RASTERIZE_BLOCK_SIZE), y0);
+		const auto byEnd = std::min(HiZ.OriginY + (BlockY * RASTERIZE_BLOCK_SIZE) + RASTERIZE_BLOCK_SIZE - 1, y1);
+		const auto fy0 = fp32(by) + 0.5f - Setup.OriginY;
+		const auto fy1 = fp32(byEnd) + 0.5f - Setup.OriginY;
+		const auto iy0 = FixedY(by);
+		const auto iy1 = FixedY(byEnd);
+
+		for (auto BlockX = BlockX0; BlockX <= BlockX1; ++BlockX)
+		{
+			const auto bx = HiZ.OriginX + (BlockX * RASTERIZE_BLOCK_SIZE);
+
+			// ブロックの中で描画範囲に入っている部分の四隅で辺の式を調べる
+			// ・どれかの辺の最大値が負なら三角形の外なので何もしない
+			// ・すべての辺の最小値が0以上なら全部三角形の中なのでピクセルごとの判定を省く
+			const auto bxBegin = std::max(bx, x0);
+			const auto bxEnd = std::min(bx + RASTERIZE_BLOCK_SIZE - 1, x1);
+			const auto fx0 = fp32(bxBegin) + 0.5f - Setup.OriginX;
+			const auto fx1 = fp32(bxEnd) + 0.5f - Setup.OriginX;
+			const auto ix0 = FixedX(bxBegin);
+			const auto ix1 = FixedX(bxEnd);
+
+			int64 Min0, Max0, Min1, Max1, Min2, Max2;
+			EdgeRange(e0, ix0, iy0, ix1, iy1, Min0, Max0);
+			EdgeRange(e1, ix0, iy0, ix1, iy1, Min1, Max1);
+			EdgeRange(e2, ix0, iy0, ix1, iy1, Min2, Max2);
+			if ((Max0 < 0) || (Max1 < 0) || (Max2 < 0)) continue;
+
+			// ブロックの中の三角形の一番手前がブロックの深度の最大値より奥なら何もしない
+			// 平面の式は三角形の外では頂点の範囲を超えるので三角形の最小値でも抑える
+			fp32 MinZ, MaxZ;
+			PlaneRange(pz, fx0, fy0, fx1, fy1, MinZ, MaxZ);
+			if (std::max(MinZ, Setup.MinZ) >= HiZ.BlockMaxZ[BlockY][BlockX]) continue;
+
+			const bool IsFullyCovered = (Min0 >= 0) && (Min1 >= 0) && (Min2 >= 0);
+
+			// ブロックの左端のピクセルでの辺の式の値（行ごとに整数で足していく）
+			auto Row0 = int32((int64(e0.a) * FixedX(bx)) + (int64(e0.b) * iy0) + e0.c);
+			auto Row1 = int32((int64(e1.a) * FixedX(bx)) + (int64(e1.b) * iy0) + e1.c);
+			auto Row2 = int32((int64(e2.a) * FixedX(bx)) + (int64(e2.b) * iy0) + e2.c);
+
+			// 平面の原点からのピクセル中心の位置
+			const auto fx = SIMD_Add(Ramp, SIMD_Set(fp32(bx) + 0.5f - Setup.OriginX));
+			const auto px = SIMD_Add(Ramp, SIMD_Set(fp32(bx)));
+			const auto InsideX = SIMD_And(SIMD_CmpGE(px, MinX), SIMD_CmpLE(px, MaxX));
+
+			const auto Offset = Target.GetOffset(bx, by);
+			auto pDepthBuffer = Target.pDepth + Offset;
+			auto pGBuffer = IsVisibility ? nullptr : Target.pGBuffer + Offset;
+			auto pVisibility = IsVisibility ? Target.pVisibility + Offset : nullptr;
+
+			bool IsWritten = false;
+			auto fy = fy0;
+			// GBufferと可視バッファは使う方だけを行の位置で参照する
+			int32 RowOffset = 0;
+			for (auto y = by; y <= byEnd; ++y, fy += 1.0f, Row0 += StepY0, Row1 += StepY1, Row2 += StepY2, pDepthBuffer += Target.Pitch, RowOffset += Target.Pitch)
+			{
+				auto Inside = InsideX;
+				if (!IsFullyCovered)
+				{
+					const auto b0 = SIMD_AddInt(SIMD_SetInt(Row0), StepX0);
+					const auto b1 = SIMD_AddInt(SIMD_SetInt(Row1), StepX1);
+					const auto b2 = SIMD_AddInt(SIMD_SetInt(Row2), StepX2);
+					Inside = SIMD_And(Inside, SIMD_CmpGTInt(b0, MinusOne));
+					Inside = SIMD_And(Inside, SIMD_CmpGTInt(b1, MinusOne));
+					Inside = SIMD_And(Inside, SIMD_CmpGTInt(b2, MinusOne));
+					if (SIMD_MoveMask(Inside) == 0) continue;
+				}
+
+				// 深度テストに通ったピクセルだけ書き込む
+				const auto z = SIMD_MulAdd(SIMD_Set(pz.a), fx, SIMD_Set((pz.b * fy) + pz.c));
+				const auto Depth = SIMD_Load(pDepthBuffer);
+				const auto Pass = SIMD_And(Inside, SIMD_CmpLT(z, Depth));
+				auto PassMask = SIMD_MoveMask(Pass);
+				if (PassMask == 0) continue;
+
+				SIMD_Store(pDepthBuffer, SIMD_Select(Pass, z, Depth));
+				IsWritten = true;
+
+				// 可視バッファにはセットアップ結果の番号だけを書き込んで、属性はシェーディングで求める
+				if (IsVisibility)
+				{
+					while (PassMask != 0)
+					{
+						const auto i = SIMD_BitScan(PassMask);
+						PassMask &= PassMask - 1;
+						pVisibility[RowOffset + i] = SetupIndex;
+					}
+					continue;
+				}
+
+				const auto w = SIMD_Div(One, SIMD_MulAdd(SIMD_Set(pw.a), fx, SIMD_Set((pw.b * fy) + pw.c)));
+				const auto n_x = SIMD_MulAdd(SIMD_Set(nx.a), fx, SIMD_Set((nx.b * fy) + nx.c));
+				const auto n_y = SIMD_MulAdd(SIMD_Set(ny.a), fx, SIMD_Set((ny.b * fy) + ny.c));
+				const auto n_z = SIMD_MulAdd(SIMD_Set(nz.a), fx, SIMD_Set((nz.b * fy) + nz.c));
+				const auto t_u = SIMD_Mul(SIMD_MulAdd(SIMD_Set(tu.a), fx, SIMD_Set((tu.b * fy) + tu.c)), w);
+				const auto t_v = SIMD_Mul(SIMD_MulAdd(SIMD_Set(tv.a), fx, SIMD_Set((tv.b * fy) + tv.c)), w);
+
+				// 法線は八面体に投影して符号付き16ビットにする（下半分は対角線で折り返して外側の三角形に置く）
+				const auto Length = SIMD_Add(SIMD_Add(SIMD_Abs(n_x), SIMD_Abs(n_y)), SIMD_Abs(n_z));
+				const auto InvLength = SIMD_Div(One, SIMD_Max(Length, SIMD_Set(FLT_MIN)));
+				const auto ox = SIMD_Mul(n_x, InvLength);
+				const auto oy = SIMD_Mul(n_y, InvLength);
+				const auto IsLower = SIMD_CmpLT(n_z, Zero);
+				const auto NormalScale = SIMD_Set(32767.0f);
+				SIMD_StoreInt(Normal[0], SIMD_ToInt(SIMD_Mul(SIMD_Select(IsLower, SIMD_Mul(SIMD_Sub(One, SIMD_Abs(oy)), Sign(ox)), ox), NormalScale)));
+				SIMD_StoreInt(Normal[1], SIMD_ToInt(SIMD_Mul(SIMD_Select(IsLower, SIMD_Mul(SIMD_Sub(One, SIMD_Abs(ox)), Sign(oy)), oy), NormalScale)));
+
+				// UVは小数部を16ビットにする（1.0に丸められた値は16ビットで0に戻る）
+				const auto TexCoordScale = SIMD_Set(65536.0f);
+				SIMD_StoreInt(TexCoord[0], SIMD_ToInt(SIMD_Mul(SIMD_Sub(t_u, SIMD_Floor(t_u)), TexCoordScale)));
+				SIMD_StoreInt(TexCoord[1], SIMD_ToInt(SIMD_Mul(SIMD_Sub(t_v, SIMD_Floor(t_v)), TexCoordScale)));
+
+				// GBufferは構造体の配列なので1ピクセルずつ書き込む
+				while (PassMask != 0)
+				{
+					const auto i = SIMD_BitScan(PassMask);
+					PassMask &= PassMask - 1;
+
+					auto& GBuff = pGBuffer[RowOffset + i];
+					GBuff.TextureId   = TextureId;
+					GBuff.TriangleId  = TriangleId;
+					GBuff.Normal[0]   = int16(Normal[0][i]);
+					GBuff.Normal[1]   = int16(Normal[1][i]);
+					GBuff.TexCoord[0] = uint16(TexCoord[0][i]);
+					GBuff.TexCoord[1] = uint16(TexCoord[1][i]);
+				}
+			}
+
+			if (IsWritten)
+			{
+				UpdateHiZBlock(HiZ, Target, BlockX, BlockY);
+			}
+		}
+	}
+}
+
+//======================================================================================================
+// 深度バッファからブロックの深度の最大値を求めなおす
+//======================================================================================================
+void Renderer::UpdateHiZBlock(RasterizeHiZ& HiZ, const RasterizeTarget& Target, int32 BlockX, int32 BlockY)
 {
-	auto pGPixel = _pGBuffer->GetPixelPointer(x, y);
-	auto pColorBuffer = _pColorBuffer->GetPixelPointer(x, y);
+	const auto x = HiZ.OriginX + (BlockX * RASTERIZE_BLOCK_SIZE);
+	const auto y = HiZ.OriginY + (BlockY * RASTERIZE_BLOCK_SIZE);
+	const auto h = std::min(RASTERIZE_BLOCK_SIZE, HiZ.OriginY + BUFFER_TILE_SIZE_Y - y);
 
-	fp32 LastU = 0.0f, LastV = 0.0f;
-	uint16 TriangleId = 0xFFFF;
-	const int32 count = w * h;
-	for (int32 i = 0; i < count; ++i, ++pGPixel, ++pColorBuffer)
+	auto pDepthBuffer = Target.pDepth + Target.GetOffset(x, y);
+	auto MaxZ = SIMD_Load(pDepthBuffer);
+	for (int32 i = 1; i < h; ++i)
 	{
-		const auto GBuff = *pGPixel;
+		pDepthBuffer += Target.Pitch;
+		MaxZ = SIMD_Max(MaxZ, SIMD_Load(pDepthBuffer));
+	}
 
-		auto bChangedTriangle = TriangleId - GBuff.TriangleId;
-		TriangleId = GBuff.TriangleId;
+	HiZ.BlockMaxZ[BlockY][BlockX] = SIMD_ReduceMax(MaxZ);
+	HiZ.IsTileDirty = true;
+}
 
-		if (GBuff.TextureId == 0xFFFF) continue;
+//======================================================================================================
+// ピクセルごとのテクスチャマッピングとライティング
+//  Fetch(px, py, Pixel) でピクセルの法線とUVとマテリアル情報を取り出し、三角形がなければfalseを返す
+//  ミップレベルは同じ三角形の隣のピクセルとのUVの差で選ぶ（左隣を優先して、なければ右隣）
+//  隣はタイルの中だけで探すので、行ごとに処理してもタイルごとに処理しても同じ結果になる
+//  三角形のないタイルはラスタライズでクリアしてあるので読まず、ほかのタイルは三角形のないピクセルにクリアした色を書く
+//======================================================================================================
+template <typename FETCH>
+void Renderer::ShadePixels(int32 x, int32 y, int32 w, int32 h, FETCH Fetch)
+{
+	ASSERT((x % BUFFER_TILE_SIZE_X) == 0);
+	ASSERT(((w % BUFFER_TILE_SIZE_X) == 0) || (x + w == SCREEN_WIDTH));
+
+	const auto ClearColor = _pColorBuffer->GetClearValue();
+
+	for (int32 py = y; py < y + h; ++py)
+	{
+		auto pColorBuffer = _pColorBuffer->GetPixelPointer(x, py);
+
+		const auto& IsTileEmpty = _IsTileEmpty[py / BUFFER_TILE_SIZE_Y];
+		const auto FetchPixel = [&](int32 px, ShadingData& Pixel)
+		{
+			return !IsTileEmpty[px / BUFFER_TILE_SIZE_X] && Fetch(px, py, Pixel);
+		};
+
+		// 右隣を1つ先に取り出しておく
+		ShadingData Last, Pixel, Next;
+		bool IsLastCovered = false;
+		bool IsCovered = FetchPixel(x, Pixel);
+		for (int32 px = x; px < x + w; ++px, ++pColorBuffer)
+		{
+			const auto IsNextCovered = (px + 1 < x + w) && FetchPixel(px + 1, Next);
+			if (IsCovered)
+			{
+				Vector3 Normal;
+				Vector_Normalize(Normal, Pixel.Normal);
+				const auto NdotL = Vector_DotProduct(Normal, _DirectionalLight) * 0.25f + 0.75f;
+
+				// タイルの左端では左隣を、右端では右隣を使わない
+				const ShadingData* pNeighbor = nullptr;
+				if (IsLastCovered && ((px % BUFFER_TILE_SIZE_X) != 0) && (Last.TriangleId == Pixel.TriangleId))
+				{
+					pNeighbor = &Last;
+				}
+				else if (IsNextCovered && (((px + 1) % BUFFER_TILE_SIZE_X) != 0) && (Next.TriangleId == Pixel.TriangleId))
+				{
+					pNeighbor = &Next;
+				}
 
-		Vector3 Normal;
-		Vector_Normalize(Normal, GBuff.Normal);
-		const auto NdotL = Vector_DotProduct(Normal, _DirectionalLight) * 0.25f + 0.75f;
+				auto pTexture = _Textures[Pixel.TextureId];
+				Color texel;
+				if (pNeighbor != nullptr)
+				{
+					// GBufferのUVは繰り返しの中の位置なので、隣のピクセルとの差は繰り返しをまたいだ分を戻す
+					auto du = pNeighbor->TexCoord.x - Pixel.TexCoord.x;
+					auto dv = pNeighbor->TexCoord.y - Pixel.TexCoord.y;
+					du -= floorf(du + 0.5f);
+					dv -= floorf(dv + 0.5f);
+					texel = pTexture->Sample(Pixel.TexCoord.x, Pixel.TexCoord.y, du, dv);
+				}
+				else
+				{
+					texel = pTexture->Sample(Pixel.TexCoord.x, Pixel.TexCoord.y);
+				}
 
-		auto pTexture = _Textures[GBuff.TextureId];
-		Color texel = bChangedTriangle
-			? pTexture->Sample(GBuff.TexCoord.x, GBuff.TexCoord.y)
-			: pTexture->Sample(GBuff.TexCoord.x, GBuff.TexCoord.y, LastU - GBuff.TexCoord.x, LastV - GBuff.TexCoord.y);
-		LastU = GBuff.TexCoord.x;
-		LastV = GBuff.TexCoord.y;
+				const auto Brightness = uint32(NdotL * 128.0f);
+				pColorBuffer->r = (texel.r * Brightness) >> 7;
+				pColorBuffer->g = (texel.g * Brightness) >> 7;
+				pColorBuffer->b = (texel.b * Brightness) >> 7;
+			}
+			else if (!IsTileEmpty[px / BUFFER_TILE_SIZE_X])
+			{
+				*pColorBuffer = ClearColor;
+			}
 
-		const auto Brightness = uint32(NdotL * 128.0f);
-		pColorBuffer->r = (texel.r * Brightness) >> 7;
-		pColorBuffer->g = (texel.g * Brightness) >> 7;
-		pColorBuffer->b = (texel.b * Brightness) >> 7;
+			Last = Pixel;
+			IsLastCovered = IsCovered;
+			Pixel = Next;
+			IsCovered = IsNextCovered;
+		}
 	}
 }
 
+//======================================================================================================
+//
+//======================================================================================================
+void Renderer::DeferredShading(const RasterizeTarget& Source, int32 x, int32 y, int32 w, int32 h)
+{
+	ShadePixels(x, y, w, h, [&](int32 px, int32 py, ShadingData& Pixel)
+	{
+		const auto GBuff = Source.pGBuffer[Source.GetOffset(px, py)];
+		if (GBuff.TextureId == INVALID_TEXTURE_ID) return false;
+
+		Pixel.TextureId		= GBuff.TextureId;
+		Pixel.TriangleId	= GBuff.TriangleId;
+		Pixel.Normal		= DecodeNormal(GBuff.Normal);
+		Pixel.TexCoord.x	= DecodeTexCoord(GBuff.TexCoord[0]);
+		Pixel.TexCoord.y	= DecodeTexCoord(GBuff.TexCoord[1]);
+		return true;
+	});
+}
+
+//======================================================================================================
+// 可視バッファのシェーディング
+//  ピクセルの三角形のセットアップ結果から重心座標を掛けた平面の式で属性を求める
+//  ラスタライズと同じ式で求めるのでGBufferの圧縮による誤差はない
+//======================================================================================================
+void Renderer::VisibilityShading(const RasterizeTarget& Source, int32 x, int32 y, int32 w, int32 h)
+{
+	// 隣のピクセルは同じ三角形のことが多いのでセットアップ結果の参照を使いまわす
+	uint32 LastSetupIndex = INVALID_VISIBILITY_ID;
+	const RasterizeSetupData* pSetup = nullptr;
+	ShadePixels(x, y, w, h, [&](int32 px, int32 py, ShadingData& Pixel)
+	{
+		const auto SetupIndex = Source.pVisibility[Source.GetOffset(px, py)];
+		if (SetupIndex == INVALID_VISIBILITY_ID) return false;
+		if (SetupIndex != LastSetupIndex)
+		{
+			pSetup = &GetSetup(SetupIndex);
+			LastSetupIndex = SetupIndex;
+		}
+
+		const auto& Setup = *pSetup;
+		const auto fx = fp32(px) + 0.5f - Setup.OriginX;
+		const auto fy = fp32(py) + 0.5f - Setup.OriginY;
+		const auto Plane = [&](const RasterizePlane& p) { return (p.a * fx) + ((p.b * fy) + p.c); };
+
+		const auto ClipW = 1.0f / Plane(Setup.InvW);
+		Pixel.TextureId		= Setup.TextureId;
+		Pixel.TriangleId	= Setup.TriangleId;
+		Pixel.Normal.x		= Plane(Setup.Normal[0]);
+		Pixel.Normal.y		= Plane(Setup.Normal[1]);
+		Pixel.Normal.z		= Plane(Setup.Normal[2]);
+		Pixel.TexCoord.x	= Plane(Setup.TexCoord[0]) * ClipW;
+		Pixel.TexCoord.y	= Plane(Setup.TexCoord[1]) * ClipW;
+		return true;
+	});
+}
+
 //======================================================================================================
 //
 //======================================================================================================
@@ -502,7 +1645,7 @@ void Renderer::SetDirectionalLight(const Vector3& Direction)
 //======================================================================================================
 //
 //======================================================================================================
-void Renderer::DrawIndexed(const IMeshData* pMeshData, const Matrix& mWorld)
+void Renderer::DrawIndexed(const IMeshData* pMeshData, const Matrix& mWorld, bool IsOccluder)
 {
-	_RenderMeshDatas.emplace_back(RenderMeshData{ pMeshData,_CurrentTriangleId++, _CurrentTextureId, mWorld });
+	_RenderMeshDatas.emplace_back(RenderMeshData{ pMeshData,_CurrentTriangleId++, _CurrentTextureId, IsOccluder, mWorld });
 }
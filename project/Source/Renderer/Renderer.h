@@ -19,8 +19,11 @@
 //======================================================================================================
 #include <Math/Math.h>
 #include <Misc/Atomic.h>
+#include <Misc/FrameArena.h>
 #include <Renderer/FrameBuffer.h>
 #include <Renderer/Texture.h>
+#include <Renderer/OcclusionBuffer.h>
+#include <Renderer/MeshCluster.h>
 
 //======================================================================================================
 //
@@ -36,6 +39,22 @@ struct IMeshData
 	virtual const Vector3* const GetNormal() const = 0;
 	virtual const Vector2* const GetTexCoord() const = 0;
 	virtual const uint16* const GetIndex() const = 0;
+
+	// x,y,zを別々に並べた頂点（GetVertexCount個ずつx,y,zの順、作っていなければnullptr）
+	virtual const fp32* const GetPositionSoA() const = 0;
+	virtual const fp32* const GetNormalSoA() const = 0;
+
+	virtual const Vector3& GetBoundingMin() const = 0;
+	virtual const Vector3& GetBoundingMax() const = 0;
+	virtual const Vector3& GetBoundingCenter() const = 0;
+	virtual const fp32 GetBoundingRadius() const = 0;
+
+	// クラスタに分割していなければGetClusterCountは0
+	virtual const int32 GetClusterCount() const = 0;
+	virtual const MeshCluster* const GetCluster() const = 0;
+	virtual const uint16* const GetClusterVertex() const = 0;
+	virtual const uint16* const GetClusterIndex() const = 0;
+	virtual const uint32* const GetClusterTriangle() const = 0;
 };
 
 struct MeshData : public IMeshData
@@ -45,6 +64,16 @@ struct MeshData : public IMeshData
 	std::vector<Vector3>	_Normal;
 	std::vector<Vector2>	_TexCoord;
 	std::vector<uint16>		_Index;
+	std::vector<fp32>		_PositionSoA;
+	std::vector<fp32>		_NormalSoA;
+	Vector3					_BoundingMin;
+	Vector3					_BoundingMax;
+	Vector3					_BoundingCenter;
+	fp32					_BoundingRadius;
+	std::vector<MeshCluster>	_Clusters;
+	std::vector<uint16>		_ClusterVertices;
+	std::vector<uint16>		_ClusterIndices;
+	std::vector<uint32>		_ClusterTriangles;
 
 	virtual const Texture* GetTexture() const { return &_Texture; }
 
@@ -55,16 +84,108 @@ struct MeshData : public IMeshData
 	virtual const Vector3* const GetNormal() const { return &_Normal[0]; }
 	virtual const Vector2* const GetTexCoord() const { return &_TexCoord[0]; }
 	virtual const uint16* const GetIndex() const { return &_Index[0]; }
+
+	virtual const fp32* const GetPositionSoA() const { return _PositionSoA.empty() ? nullptr : &_PositionSoA[0]; }
+	virtual const fp32* const GetNormalSoA() const { return _NormalSoA.empty() ? nullptr : &_NormalSoA[0]; }
+
+	virtual const Vector3& GetBoundingMin() const { return _BoundingMin; }
+	virtual const Vector3& GetBoundingMax() const { return _BoundingMax; }
+	virtual const Vector3& GetBoundingCenter() const { return _BoundingCenter; }
+	virtual const fp32 GetBoundingRadius() const { return _BoundingRadius; }
+
+	virtual const int32 GetClusterCount() const { return int32(_Clusters.size()); }
+	virtual const MeshCluster* const GetCluster() const { return _Clusters.empty() ? nullptr : &_Clusters[0]; }
+	virtual const uint16* const GetClusterVertex() const { return _ClusterVertices.empty() ? nullptr : &_ClusterVertices[0]; }
+	virtual const uint16* const GetClusterIndex() const { return _ClusterIndices.empty() ? nullptr : &_ClusterIndices[0]; }
+	virtual const uint32* const GetClusterTriangle() const { return _ClusterTriangles.empty() ? nullptr : &_ClusterTriangles[0]; }
+
+	// クラスタに分割する（頂点やインデックスを変更したら呼ぶこと）
+	void BuildClusters()
+	{
+		MeshCluster_Build(_Clusters, _ClusterVertices, _ClusterIndices, _ClusterTriangles, _Position.data(), GetVertexCount(), _Index.data(), GetIndexCount());
+	}
+
+	// 位置と法線をSoAでも持つ（頂点を変更したら呼ぶこと）
+	//  頂点変換で並べ替えずにSIMDで読めるようになる
+	void BuildSoA()
+	{
+		const auto VertexCount = _Position.size();
+		_PositionSoA.resize(VertexCount * 3);
+		_NormalSoA.resize(VertexCount * 3);
+		for (size_t i = 0; i < VertexCount; ++i)
+		{
+			_PositionSoA[i                  ] = _Position[i].x;
+			_PositionSoA[i + VertexCount    ] = _Position[i].y;
+			_PositionSoA[i + VertexCount * 2] = _Position[i].z;
+			_NormalSoA[i                  ] = _Normal[i].x;
+			_NormalSoA[i + VertexCount    ] = _Normal[i].y;
+			_NormalSoA[i + VertexCount * 2] = _Normal[i].z;
+		}
+	}
+
+	// 頂点の位置からバウンディングボックスと、その中心を中心にした球を求める（頂点を変更したら呼ぶこと）
+	void UpdateBounds()
+	{
+		_BoundingMin = _BoundingMax = _Position.empty() ? Vector3{ 0.0f, 0.0f, 0.0f } : _Position[0];
+		for (auto&& p : _Position)
+		{
+			Vector_Min(_BoundingMin, _BoundingMin, p);
+			Vector_Max(_BoundingMax, _BoundingMax, p);
+		}
+
+		Vector_Add(_BoundingCenter, _BoundingMin, _BoundingMax);
+		Vector_Mul(_BoundingCenter, _BoundingCenter, 0.5f);
+
+		fp32 RadiusSq = 0.0f;
+		for (auto&& p : _Position)
+		{
+			Vector3 d;
+			RadiusSq = std::max(RadiusSq, Vector_LengthSq(Vector_Sub(d, p, _BoundingCenter)));
+		}
+		_BoundingRadius = sqrtf(RadiusSq);
+	}
 };
 
 struct InternalVertex
 {
 	Vector4		Position;
 	Vector3		Normal;
-	Vector2		TexCoord;
 };
 
+// 画面座標に対する平面の式 x * a + y * b + c（原点は画面の左上）
+struct ScreenPlane
+{
+	fp64	a;
+	fp64	b;
+	fp64	c;
+};
+
+// 切り取る前の三角形のクリップ空間の頂点から求めた、パースペクティブ補正する属性の平面の式
+//  z/w、1/w、UV/wは画面座標の1次式なので、頂点がニアより手前にあっても元の三角形から求まる
+//  切り取った三角形もこの式で補間するので、切り取りの有無で補間の結果が変わらない
+struct TrianglePlanes
+{
+	ScreenPlane	Depth;
+	ScreenPlane	InvW;
+	ScreenPlane	TexCoord[2];
+};
+
+// GBufferの1ピクセル（12バイト）
+//  法線は八面体に投影した2成分を符号付き16ビット、UVは繰り返しの中の位置（小数部）を16ビットで持つ
 struct GBufferData
+{
+	uint16		TextureId;
+	uint16		TriangleId;
+	int16		Normal[2];
+	uint16		TexCoord[2];
+};
+static_assert(sizeof(GBufferData) == 12, "GBufferDataは12バイトに詰める");
+
+// GBufferで三角形が描かれていないピクセルのTextureId（GBufferはこの値でクリアしておく）
+static const uint16 INVALID_TEXTURE_ID = 0xFFFF;
+
+// シェーディングで使う1ピクセル分の情報（GBufferや可視バッファから取り出したもの）
+struct ShadingData
 {
 	uint16		TextureId;
 	uint16		TriangleId;
@@ -77,28 +198,140 @@ struct RenderMeshData
 	const IMeshData*	pMeshData;
 	uint16				TriangleId;
 	uint16				TextureId;
+	bool				IsOccluder;
 	Matrix				mWorld;
 	Matrix				mViewProj;
+	Vector4*			pPositions;		// クラスタに分割していないメッシュの変換済みの頂点（フレームのアリーナから確保）
+	Vector3*			pNormals;
+};
+
+// 頂点変換のジョブ1つ分（クラスタに分割していないメッシュの頂点をGEOMETRY_BATCH_VERTEX_COUNT個ずつ）
+struct VertexJobData
+{
+	const RenderMeshData*	pMesh;
+	int32					VertexOffset;
+	int32					VertexCount;
+	bool					IsOcclusionCulling;
+};
+
+// ジオメトリ処理のジョブ1つ分
+//  クラスタに分割してあればクラスタの範囲、なければ三角形の範囲（どちらも三角形がおよそGEOMETRY_BATCH_TRIANGLE_COUNT個）
+struct GeometryJobData
+{
+	const RenderMeshData*	pMesh;
+	int32					Offset;
+	int32					Count;
+	bool					IsOcclusionCulling;
+};
+
+// 属性などを (x - OriginX) * a + (y - OriginY) * b + c で求める平面の式
+struct RasterizePlane
+{
+	fp32	a;
+	fp32	b;
+	fp32	c;
 };
 
-struct RasterizeTriangleData
+// 1/16ピクセルに丸めた画面座標を28.4の固定小数点にする（誤差なく変換できる）
+//  ガードバンドの中なら辺の式の値もint32に収まる
+inline int32 ToFixed(fp32 v) { return int32(v * 16.0f); }
+
+// 左上ルール：左の辺（a > 0）と上の辺（a == 0 で b > 0）はちょうど辺の上のピクセルも塗り、それ以外の辺は塗らない
+//  隣り合う三角形が共有する辺の上のピクセルは片方だけが塗る
+inline bool IsTopLeftEdge(int32 a, int32 b) { return (a > 0) || ((a == 0) && (b > 0)); }
+
+// 辺の式 (X - FixedOriginX) * a + (Y - FixedOriginY) * b + c（座標は28.4の固定小数点）
+//  0以上なら三角形の中で、左上ルールで塗らない辺はcを1小さくしてある
+struct RasterizeEdge
 {
+	int32	a;
+	int32	b;
+	int32	c;
+};
+
+// 三角形のセットアップ結果（フレームの間共有して、タイルからはインデックスで参照する）
+struct RasterizeSetupData
+{
+	RasterizeEdge	Edge[3];
+	RasterizePlane	Depth;
+	RasterizePlane	InvW;
+	RasterizePlane	Normal[3];
+	RasterizePlane	TexCoord[2];
+	fp32			OriginX;
+	fp32			OriginY;
+	int32			FixedOriginX;
+	int32			FixedOriginY;
+	fp32			MinZ;
 	int16			bbMinX;
 	int16			bbMinY;
 	int16			bbMaxX;
 	int16			bbMaxY;
 	uint16			TriangleId;
 	uint16			TextureId;
-	fp32			InvDenom;
-	InternalVertex	v0;
-	InternalVertex	v1;
-	InternalVertex	v2;
+	uint32			DrawNo;
+};
+
+struct RasterizeSetupBlock
+{
+	RasterizeSetupData	Setups[RASTERIZE_SETUP_BLOCK];
+};
+
+// タイル内のRASTERIZE_BLOCK_SIZE四方のブロックごとの深度の最大値（階層Z）
+//  ラスタライズ中のタイルだけが持つ値で、これ以上奥の三角形はブロックやタイルごと捨てる
+struct RasterizeHiZ
+{
+	int32	OriginX;
+	int32	OriginY;
+	fp32	TileMaxZ;
+	bool	IsTileDirty;
+	fp32	BlockMaxZ[TILE_BLOCK_COUNT_Y][TILE_BLOCK_COUNT_X];
+};
+
+// ラスタライズの書き込み先とシェーディングの読み込み元
+//  タイルだけの作業用のバッファか、シェーディングで読む画面全体のバッファを指す
+struct RasterizeTarget
+{
+	int32			OriginX;		// 各バッファの先頭のピクセルの位置
+	int32			OriginY;
+	int32			Pitch;			// 1行のピクセル数
+	fp32*			pDepth;
+	GBufferData*	pGBuffer;
+	uint32*			pVisibility;	// 可視バッファを使わないときはnullptr
+
+	int32 GetOffset(int32 x, int32 y) const { return (x - OriginX) + ((y - OriginY) * Pitch); }
+};
+
+// タイルだけの作業用のバッファ（スレッドごとに1つ）
+//  タイルの深度とGBufferを連続したメモリに置いて、深度テストをL1キャッシュの中で済ませる
+struct RasterizeTileBuffer
+{
+	fp32			Depth[BUFFER_TILE_SIZE_Y][BUFFER_TILE_SIZE_X];
+	GBufferData		GBuffer[BUFFER_TILE_SIZE_Y][BUFFER_TILE_SIZE_X];
+	uint32			Visibility[BUFFER_TILE_SIZE_Y][BUFFER_TILE_SIZE_X];
 };
 
+// タイルに積まれる三角形のインデックスの入れ物（フレームのアリーナから確保して積まれた順につなぐ）
+struct RasterizeChunk
+{
+	RasterizeChunk*	pNext;
+	int32			Count;
+	uint32			SetupIndices[RASTERIZE_CHUNK_SIZE];
+};
+
+struct RasterizeBin
+{
+	RasterizeChunk*	pHead;
+	RasterizeChunk*	pTail;
+};
+
+// スレッドごとの全タイルの入れ物
+// 他のスレッドと共有しないのでアトミック操作なしで積める
 struct RasterizeData
 {
-	std::vector<RasterizeTriangleData>	Triangles;
-	Atomic								Count;
+	RasterizeBin	Bins[MAX_TILE_COUNT_Y][MAX_TILE_COUNT_X];
+	int32			SetupBlockNo;
+	int32			SetupCount;
+	uint8			Padding[64];	// 隣のスレッドの入れ物とキャッシュラインを共有しないように
 };
 
 //======================================================================================================
@@ -107,6 +340,10 @@ struct RasterizeData
 typedef FrameBuffer<Color>			ColorBuffer;
 typedef FrameBuffer<fp32>			DepthBuffer;
 typedef FrameBuffer<GBufferData>	GBuffer;
+typedef FrameBuffer<uint32>			VisibilityBuffer;
+
+// 可視バッファで三角形が描かれていないピクセルの値
+static const uint32 INVALID_VISIBILITY_ID = 0xFFFFFFFF;
 
 //======================================================================================================
 //
@@ -116,17 +353,33 @@ class Renderer
 	ColorBuffer*				_pColorBuffer;
 	DepthBuffer*				_pDepthBuffer;
 	GBuffer*					_pGBuffer;
+	VisibilityBuffer			_VisibilityBuffer;
+	RasterizeTarget				_ScreenTarget;
 	std::vector<RenderMeshData>	_RenderMeshDatas;
+	std::vector<VertexJobData>		_VertexJobs;
+	std::vector<GeometryJobData>	_GeometryJobs;
 	Matrix						_ViewMatrix;
 	Matrix						_ProjMatrix;
 	Matrix						_mViewProj;
+	Vector3						_CameraPosition;
 	Vector3						_DirectionalLight;
 	Texture						_DummyTexture;
 	Texture*					_CurrentTexture;
 	std::vector<Texture*>		_Textures;
 	uint16						_CurrentTextureId;
 	uint16						_CurrentTriangleId;
-	RasterizeData				_RasterizeDatas[MAX_TILE_COUNT_Y][MAX_TILE_COUNT_X];
+	std::vector<RasterizeData>	_RasterizeDatas;
+	FrameArena					_RasterizeArena;
+	std::vector<RasterizeSetupBlock*>	_SetupBlocks;
+	bool						_IsTileEmpty[MAX_TILE_COUNT_Y][MAX_TILE_COUNT_X];	// 三角形がなくクリアした値で埋めたタイル
+	Atomic						_SetupBlockCount;
+	Atomic						_DroppedTriangleCount;
+	Vector4						_FrustumPlanes[6];
+	OcclusionBuffer				_OcclusionBuffer;
+	bool						_IsOcclusionCullingEnabled;
+	bool						_IsVisibilityBufferEnabled;
+	bool						_IsTileShadingEnabled;
+	bool						_IsDepthOutputEnabled;
 
 public:
 	Renderer();
@@ -163,7 +416,6 @@ private:
 				const fp32 rate = d1 / (d1 - d2);
 				Vector_Lerp(v.Position, v1.Position, v2.Position, rate);
 				Vector_Lerp(v.Normal, v1.Normal, v2.Normal, rate);
-				Vector_Lerp(v.TexCoord, v1.TexCoord, v2.TexCoord, rate);
 			};
 
 			if (d1 > 0.0f)
@@ -190,14 +442,32 @@ private:
 		return NewPointCount;
 	}
 
-	void PushTriangleToTile(
-		int32 tx, int32 ty,
-		fp32 bbMinX, fp32 bbMinY, fp32 bbMaxX, fp32 bbMaxY, fp32 InvDenom,
-		uint16 TriangleId, uint16 TextureId, InternalVertex v0, InternalVertex v1, InternalVertex v2);
-	void RasterizeTriangle(uint16 TriangleId, uint16 TextureId, InternalVertex v0, InternalVertex v1, InternalVertex v2);
-	void RasterizeTile(int32 tx, int32 ty);
-	void RenderTriangle(uint16 TriangleId, uint16_t TextureId, const IMeshData* pMeshData, const Vector4 Positions[], const Vector3 Normals[], const Vector2 Texcoord[], const int32 VertexCount, const uint16* pIndex, const int32 IndexCount);
-	void DeferredShading(int32 x, int32 y, int32 w, int32 h);
+	const RasterizeSetupData& GetSetup(uint32 SetupIndex) const
+	{
+		return _SetupBlocks[SetupIndex / RASTERIZE_SETUP_BLOCK]->Setups[SetupIndex % RASTERIZE_SETUP_BLOCK];
+	}
+	RasterizeSetupData* AllocateSetup(RasterizeData& Dst, uint32& SetupIndex);
+	uint32* AllocateBinEntry(RasterizeBin& Bin);
+	void PushTriangleToTile(RasterizeData& Dst, int32 tx, int32 ty, uint32 SetupIndex);
+	void RasterizeTriangle(RasterizeData& Dst, uint32 DrawNo, uint16 TriangleId, uint16 TextureId, const TrianglePlanes& Planes, InternalVertex v0, InternalVertex v1, InternalVertex v2);
+	bool RasterizeTile(int32 tx, int32 ty, const RasterizeTarget& Target);
+	void RasterizeTileTriangle(const RasterizeSetupData& Setup, uint32 SetupIndex, RasterizeHiZ& HiZ, const RasterizeTarget& Target, int32 x0, int32 y0, int32 x1, int32 y1);
+	void UpdateHiZBlock(RasterizeHiZ& HiZ, const RasterizeTarget& Target, int32 BlockX, int32 BlockY);
+	RasterizeTarget GetTileTarget(int32 tx, int32 ty) const;
+	void RasterizeTileToScreen(int32 tx, int32 ty);
+	void RasterizeAndShadeTile(int32 tx, int32 ty);
+	void RenderTriangle(RasterizeData& Dst, uint32 DrawNo, uint16 TriangleId, uint16_t TextureId, const IMeshData* pMeshData, const Vector4 Positions[], const Vector3 Normals[], const Vector2 Texcoord[], const int32 VertexCount, const uint16* pIndex, const int32 IndexCount);
+	template <typename FETCH>
+	void ShadePixels(int32 x, int32 y, int32 w, int32 h, FETCH Fetch);
+	void DeferredShading(const RasterizeTarget& Source, int32 x, int32 y, int32 w, int32 h);
+	void VisibilityShading(const RasterizeTarget& Source, int32 x, int32 y, int32 w, int32 h);
+	void UpdateFrustumPlanes();
+	bool IsInFrustum(const IMeshData* pMeshData) const;
+	bool IsInFrustum(const Vector3& Center, fp32 Radius) const;
+	void ProcessGeometry(const GeometryJobData& Job, uint32 DrawNo);
+	void ProcessVertices(const VertexJobData& Job);
+	void ProcessTriangles(RasterizeData& Dst, uint32 DrawNo, const RenderMeshData& Mesh, int32 TriangleOffset, int32 TriangleCount);
+	void ProcessClusters(RasterizeData& Dst, uint32 DrawNo, const RenderMeshData& Mesh, int32 ClusterOffset, int32 ClusterCount, bool IsOcclusionCulling);
 
 public:
 	void BeginDraw(ColorBuffer* pColorBuffer, DepthBuffer* pDepthBuffer, GBuffer* pGBuffer, const Matrix& mView, const Matrix& mProj);
@@ -205,5 +475,28 @@ public:
 	void SetTexture(Texture& Texture);
 	void SetDirectionalLight(const Vector3& Direction);
 
-	void DrawIndexed(const IMeshData* pMeshData, const Matrix& mWorld);
+	// IsOccluderを指定したメッシュは遮蔽物としてオクルージョンカリングに使う
+	void DrawIndexed(const IMeshData* pMeshData, const Matrix& mWorld, bool IsOccluder = false);
+
+	// 遮蔽物に隠れたメッシュをジオメトリ処理の前に捨てる（デフォルトは無効）
+	void SetOcclusionCullingEnabled(bool IsEnabled) { _IsOcclusionCullingEnabled = IsEnabled; }
+	bool IsOcclusionCullingEnabled() const { return _IsOcclusionCullingEnabled; }
+
+	// ラスタライズでは深度と三角形のセットアップ結果の番号だけを書き込み、
+	// シェーディングで最後に見えている三角形の属性だけを求める（デフォルトは無効でGBufferを使う）
+	//  GBufferには何も書き込まない
+	void SetVisibilityBufferEnabled(bool IsEnabled) { _IsVisibilityBufferEnabled = IsEnabled; }
+	bool IsVisibilityBufferEnabled() const { return _IsVisibilityBufferEnabled; }
+
+	// タイルごとにラスタライズの直後にシェーディングまで行う（デフォルトは無効）
+	//  深度とGBufferはタイルだけの作業用のバッファに置き、画面には色だけを書き出す
+	//  画面の深度とGBufferの内容は不定になる
+	//  シェーディングのフェーズとその前のバリアがなくなる
+	void SetTileShadingEnabled(bool IsEnabled) { _IsTileShadingEnabled = IsEnabled; }
+	bool IsTileShadingEnabled() const { return _IsTileShadingEnabled; }
+
+	// タイルごとにシェーディングするときも画面の深度を書き出す（デフォルトは無効）
+	//  描画結果の深度を読み出して確認するとき用
+	void SetDepthOutputEnabled(bool IsEnabled) { _IsDepthOutputEnabled = IsEnabled; }
+	bool IsDepthOutputEnabled() const { return _IsDepthOutputEnabled; }
 };
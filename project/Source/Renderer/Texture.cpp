@@ -13,6 +13,7 @@
 //
 //======================================================================================================
 #include <Renderer/Texture.h>
+#include <Misc/File.h>
 
 //======================================================================================================
 //
@@ -124,7 +125,7 @@ bool Texture::Load(const char* pFileName)
 		uint32			dwReserved2;
 	};
 
-	DWORD ReadedBytes;
+	File DDSFile;
 	uint32 MagicNumber;
 	DDSURFACEDESC2 DDSHeader;
 
@@ -132,15 +133,14 @@ bool Texture::Load(const char* pFileName)
 
 	Release();
 
-	HANDLE hFile = ::CreateFileA(pFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-	if (hFile == INVALID_HANDLE_VALUE) goto EXIT;
+	if (!DDSFile.Open(pFileName, "rb")) goto EXIT;
 
 	// マジックナンバー
-	::ReadFile(hFile, &MagicNumber, sizeof(uint32), &ReadedBytes, nullptr);
+	if (DDSFile.Read(&MagicNumber, sizeof(uint32)) != sizeof(uint32)) goto EXIT;
 	if (MagicNumber != ' SDD') goto EXIT;
 
 	// ヘッダ
-	::ReadFile(hFile, &DDSHeader, sizeof(DDSURFACEDESC2), &ReadedBytes, nullptr);
+	if (DDSFile.Read(&DDSHeader, sizeof(DDSURFACEDESC2)) != sizeof(DDSURFACEDESC2)) goto EXIT;
 
 	if (DDSHeader.ddpfTexelFormat.dwRGBBitCount != 32) goto EXIT;
 	if (DDSHeader.ddpfTexelFormat.dwRGBAlphaBitMask != 0xFF000000) goto EXIT;
@@ -165,17 +165,14 @@ bool Texture::Load(const char* pFileName)
 		auto& Src = _Surface[i];
 
 		// ピクセルデータ読み込み
-		::ReadFile(hFile, &(Src.Color[0]), sizeof(Color) * SrcW * SrcH, &ReadedBytes, nullptr);
+		DDSFile.Read(&(Src.Color[0]), sizeof(Color) * SrcW * SrcH);
 	}
 
 	bSucceeded = true;
 
 EXIT:
 	// ファイル閉じる
-	if (hFile != INVALID_HANDLE_VALUE)
-	{
-		::CloseHandle(hFile);
-	}
+	DDSFile.Close();
 
 	if (!bSucceeded)
 	{
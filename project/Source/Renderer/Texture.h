@@ -26,7 +26,7 @@ private:
 
 	struct Surface
 	{
-		std::vector<Color>	Color;
+		std::vector<::Color>	Color;
 		int32				Width;
 		int32				Height;
 		fp32				WidthF;
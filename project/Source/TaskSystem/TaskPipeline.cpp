@@ -71,7 +71,7 @@ void TaskPipeline::Loop()
 		TaskSystem::QueData* pQueData;
 		while (System.GetQueData(pQueData))
 		{
-			System.ExecuteQue(pQueData);
+			System.ExecuteQue(pQueData, _CoreNo);
 		}
 
 		System.Completed(_CoreNo);
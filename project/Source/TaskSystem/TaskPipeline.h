@@ -27,7 +27,7 @@ class TaskPipeline
 	std::thread	_Threading;
 	Semaphore	_Semaphore;
 	int32		_CoreNo;
-	bool		_bRunning;
+	std::atomic_bool	_bRunning;
 
 private:
 	void Loop();
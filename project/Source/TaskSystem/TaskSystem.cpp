@@ -13,6 +13,12 @@
 //
 //======================================================================================================
 #include <TaskSystem/TaskSystem.h>
+#include <Misc/File.h>
+
+//======================================================================================================
+//
+//======================================================================================================
+static thread_local int32 _CurrentCoreNo = 0;
 
 //======================================================================================================
 //
@@ -33,6 +39,10 @@ void TaskSystem::Initialize()
 	_TaskData.RunningPipelineCount = 0;
 	_TaskData.IsTaskCompleted = true;
 	_TaskData.BarrierCount.clear();
+	_TaskData.PhaseNames.assign(1, nullptr);
+
+	_Profile = TaskProfile();
+	_Profile.FrameNo = -1;
 }
 
 //======================================================================================================
@@ -45,6 +55,12 @@ void TaskSystem::Finalize()
 		delete _TaskPipelines[i];
 	}
 	_TaskPipelines.clear();
+
+	// 途中で終了した場合もそこまでの記録を書き出す
+	if (IsTraceEnabled())
+	{
+		EndTrace();
+	}
 }
 
 //======================================================================================================
@@ -52,6 +68,9 @@ void TaskSystem::Finalize()
 //======================================================================================================
 void TaskSystem::Execute()
 {
+	BeginFrame();
+	const auto BeginTime = _IsTimeStampEnabled ? _Timer.GetNano() : 0;
+
 	_TaskData.IsTaskCompleted = false;
 	_TaskData.RunningPipelineCount = _PipelineCount;
 	_TaskData.QueCount = _TaskData.WriteOffset.Load();
@@ -66,15 +85,15 @@ void TaskSystem::Execute()
 	TaskSystem::QueData* pQueData;
 	while (GetQueData(pQueData))
 	{
-		ExecuteQue(pQueData);
+		ExecuteQue(pQueData, 0);
 	}
 
 	while (!_TaskData.IsTaskCompleted)
 	{
-		std::this_thread::sleep_for(std::chrono::microseconds(0));
+		std::this_thread::yield();
 	}
 
-	_TaskData.BarrierCount.clear();
+	EndFrame(BeginTime, _IsTimeStampEnabled ? _Timer.GetNano() : 0);
 }
 
 //======================================================================================================
@@ -82,6 +101,9 @@ void TaskSystem::Execute()
 //======================================================================================================
 void TaskSystem::ExecuteSingle()
 {
+	BeginFrame();
+	const auto BeginTime = _IsTimeStampEnabled ? _Timer.GetNano() : 0;
+
 	_TaskData.IsTaskCompleted = false;
 	_TaskData.RunningPipelineCount = _PipelineCount;
 	_TaskData.QueCount = _TaskData.WriteOffset.Load();
@@ -91,17 +113,27 @@ void TaskSystem::ExecuteSingle()
 	TaskSystem::QueData* pQueData;
 	while (GetQueData(pQueData))
 	{
-		ExecuteQue(pQueData);
+		ExecuteQue(pQueData, 0);
 	}
 
-	_TaskData.BarrierCount.clear();
+	EndFrame(BeginTime, _IsTimeStampEnabled ? _Timer.GetNano() : 0);
 }
 
 //======================================================================================================
 //
 //======================================================================================================
-void TaskSystem::ExecuteQue(TaskSystem::QueData* pQueData)
+void TaskSystem::ExecuteQue(TaskSystem::QueData* pQueData, int32 CoreNo)
 {
+	_CurrentCoreNo = CoreNo;
+
+	// キューのデータはフレーム内で1回しか実行されないので計測結果をそのまま書き込む
+	const bool IsTimeStampEnabled = _IsTimeStampEnabled;
+	if (IsTimeStampEnabled)
+	{
+		pQueData->CoreNo = CoreNo;
+		pQueData->BeginTime = _Timer.GetNano();
+	}
+
 	if (pQueData->BarrierID != 0)
 	{
 		const int32 Index = pQueData->BarrierID - 1;
@@ -109,13 +141,26 @@ void TaskSystem::ExecuteQue(TaskSystem::QueData* pQueData)
 		Barrier.Decrement();
 		while (Barrier.Load())
 		{
-			std::this_thread::sleep_for(std::chrono::microseconds(0));
+			std::this_thread::yield();
 		}
 	}
 	else
 	{
 		pQueData->Callback(pQueData->pData);
 	}
+
+	if (IsTimeStampEnabled)
+	{
+		pQueData->EndTime = _Timer.GetNano();
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+int32 TaskSystem::GetCurrentCoreNo()
+{
+	return _CurrentCoreNo;
 }
 
 //======================================================================================================
@@ -144,13 +189,15 @@ void TaskSystem::Completed(int32 CoreNo)
 //======================================================================================================
 //
 //======================================================================================================
-void TaskSystem::PushQue(std::function<void(void*)> Callback, void* pData)
+void TaskSystem::PushQue(std::function<void(void*)> Callback, void* pData, const char* pLabel)
 {
 	const auto Write = _TaskData.WriteOffset.Increment() - 1;
 	auto& Dst = _TaskData.Que[Write];
 	Dst.Callback = Callback;
 	Dst.pData = pData;
+	Dst.pLabel = pLabel;
 	Dst.BarrierID = 0;
+	Dst.PhaseNo = int32(_TaskData.BarrierCount.size());
 }
 
 //======================================================================================================
@@ -169,6 +216,220 @@ void TaskSystem::PushBarrier()
 		auto& Dst = _TaskData.Que[Write];
 		Dst.Callback = [](void*) {};
 		Dst.pData = nullptr;
+		Dst.pLabel = "Barrier";
 		Dst.BarrierID = BarrierId;
+		Dst.PhaseNo = BarrierId - 1;
 	}
+
+	_TaskData.PhaseNames.push_back(nullptr);
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void TaskSystem::SetPhaseName(const char* pName)
+{
+	_TaskData.PhaseNames.back() = pName;
+}
+
+//======================================================================================================
+// Executeの前処理
+//  ワーカーはKickされてから_IsTimeStampEnabledを読むのでフレーム内で値は変わらない
+//======================================================================================================
+void TaskSystem::BeginFrame()
+{
+	_IsTimeStampEnabled = _IsProfileEnabled || IsTraceEnabled();
+}
+
+//======================================================================================================
+// Executeの後処理
+//  バリアの情報を使うのでクリアする前に計測結果をまとめる
+//======================================================================================================
+void TaskSystem::EndFrame(uint64 BeginTime, uint64 EndTime)
+{
+	if (_IsProfileEnabled)
+	{
+		BuildProfile(BeginTime, EndTime);
+	}
+
+	if (IsTraceEnabled())
+	{
+		RecordTrace(BeginTime, EndTime);
+		if (--_TraceFrameCount == 0)
+		{
+			EndTrace();
+		}
+	}
+
+	_TaskData.BarrierCount.clear();
+	_TaskData.PhaseNames.assign(1, nullptr);
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void TaskSystem::BuildProfile(uint64 BeginTime, uint64 EndTime)
+{
+	const int32 PhaseCount = int32(_TaskData.PhaseNames.size());
+	const int32 WorkerCount = _PipelineCount + 1;
+	const fp64 ToMicro = 1.0 / 1000.0;
+
+	_Profile.FrameNo++;
+	_Profile.FrameTime = fp64(EndTime - BeginTime) * ToMicro;
+
+	_Profile.Phases.resize(PhaseCount);
+	for (int32 i = 0; i < PhaseCount; ++i)
+	{
+		auto& Phase = _Profile.Phases[i];
+		Phase.pName = _TaskData.PhaseNames[i];
+		Phase.WallTime = 0.0;
+		Phase.BusyTime = 0.0;
+		Phase.JobCount = 0;
+	}
+
+	_Profile.Workers.resize(WorkerCount);
+	for (int32 i = 0; i < WorkerCount; ++i)
+	{
+		auto& Worker = _Profile.Workers[i];
+		Worker.CoreNo = i;
+		Worker.BusyTime = 0.0;
+		Worker.BarrierTime = 0.0;
+		Worker.IdleTime = 0.0;
+		Worker.JobCount = 0;
+	}
+
+	// フェーズの終わりは最後のスレッドがバリアに到着した時間（最後のフェーズは最後のジョブの終了時間）
+	std::vector<uint64> PhaseEndTime(PhaseCount, BeginTime);
+	for (int32 i = 0; i < _TaskData.QueCount; ++i)
+	{
+		const auto& Que = _TaskData.Que[i];
+		const auto Time = fp64(Que.EndTime - Que.BeginTime) * ToMicro;
+		auto& Phase = _Profile.Phases[Que.PhaseNo];
+		auto& Worker = _Profile.Workers[Que.CoreNo];
+		auto& PhaseEnd = PhaseEndTime[Que.PhaseNo];
+
+		if (Que.BarrierID != 0)
+		{
+			Worker.BarrierTime += Time;
+			PhaseEnd = std::max(PhaseEnd, Que.BeginTime);
+		}
+		else
+		{
+			Worker.BusyTime += Time;
+			Worker.JobCount++;
+			Phase.BusyTime += Time;
+			Phase.JobCount++;
+			PhaseEnd = std::max(PhaseEnd, Que.EndTime);
+		}
+	}
+
+	auto PhaseBeginTime = BeginTime;
+	for (int32 i = 0; i < PhaseCount; ++i)
+	{
+		const auto PhaseEnd = std::max(PhaseEndTime[i], PhaseBeginTime);
+		_Profile.Phases[i].WallTime = fp64(PhaseEnd - PhaseBeginTime) * ToMicro;
+		PhaseBeginTime = PhaseEnd;
+	}
+
+	for (auto&& Worker : _Profile.Workers)
+	{
+		Worker.IdleTime = std::max(0.0, _Profile.FrameTime - Worker.BusyTime - Worker.BarrierTime);
+	}
+}
+
+//======================================================================================================
+//
+//======================================================================================================
+void TaskSystem::BeginTrace(const char* pFileName, int32 FrameCount)
+{
+	_TraceFileName = pFileName;
+	_TraceFrameCount = std::max(1, FrameCount);
+	_TraceFrameNo = 0;
+	_TraceEvents.clear();
+}
+
+//======================================================================================================
+// 1回のExecuteで実行されたジョブを記録する
+//  ジョブのIndexはフェーズ内で積まれた順番（タイルならy*横タイル数+x、シェーディングなら帯の番号）
+//======================================================================================================
+void TaskSystem::RecordTrace(uint64 BeginTime, uint64 EndTime)
+{
+	const int32 PhaseCount = int32(_TaskData.PhaseNames.size());
+	std::vector<int32> JobIndex(PhaseCount, 0);
+
+	TraceEvent Frame;
+	Frame.pName = "Frame";
+	Frame.pPhase = nullptr;
+	Frame.CoreNo = -1;
+	Frame.Index = _TraceFrameNo++;
+	Frame.BeginTime = BeginTime;
+	Frame.EndTime = EndTime;
+	_TraceEvents.push_back(Frame);
+
+	for (int32 i = 0; i < _TaskData.QueCount; ++i)
+	{
+		const auto& Que = _TaskData.Que[i];
+
+		TraceEvent Event;
+		Event.pName = (Que.pLabel != nullptr) ? Que.pLabel : "Job";
+		Event.pPhase = _TaskData.PhaseNames[Que.PhaseNo];
+		Event.CoreNo = Que.CoreNo;
+		Event.Index = (Que.BarrierID != 0) ? -1 : JobIndex[Que.PhaseNo]++;
+		Event.BeginTime = Que.BeginTime;
+		Event.EndTime = Que.EndTime;
+		_TraceEvents.push_back(Event);
+	}
+}
+
+//======================================================================================================
+// 記録をChrome trace形式で書き出す（chrome://tracing や ui.perfetto.dev で開ける）
+//  tidはコア番号で、フレーム全体は最後の行にまとめて出す
+//======================================================================================================
+bool TaskSystem::EndTrace()
+{
+	_TraceFrameCount = 0;
+
+	File Output;
+	if (!Output.Open(_TraceFileName.c_str(), "wb"))
+	{
+		fprintf(stderr, "failed to open %s\n", _TraceFileName.c_str());
+		_TraceEvents.clear();
+		return false;
+	}
+
+	const uint64 OriginTime = _TraceEvents.empty() ? 0 : _TraceEvents.front().BeginTime;
+	const int32 WorkerCount = _PipelineCount + 1;
+	const int32 FrameTid = WorkerCount;
+
+	char Line[512];
+	auto Print = [&](const char* pFormat, ...) {
+		va_list Args;
+		va_start(Args, pFormat);
+		const int32 Length = vsnprintf(Line, sizeof(Line), pFormat, Args);
+		va_end(Args);
+		Output.Write(Line, std::min<uint64>(Length, sizeof(Line) - 1));
+	};
+
+	Print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (int32 i = 0; i < WorkerCount; ++i)
+	{
+		Print("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"Core %d%s\"}},\n",
+			i, i, (i == 0) ? " (main)" : "");
+	}
+	Print("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"Frame\"}}", FrameTid);
+
+	for (const auto& Event : _TraceEvents)
+	{
+		const fp64 Begin = fp64(Event.BeginTime - OriginTime) / 1000.0;
+		const fp64 Duration = fp64(Event.EndTime - Event.BeginTime) / 1000.0;
+		const int32 Tid = (Event.CoreNo < 0) ? FrameTid : Event.CoreNo;
+		const char* pPhase = (Event.pPhase != nullptr) ? Event.pPhase : "";
+
+		Print(",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d,\"args\":{\"index\":%d}}",
+			Event.pName, pPhase, Begin, Duration, Tid, Event.Index);
+	}
+	Print("\n]}\n");
+
+	_TraceEvents.clear();
+	return true;
 }
@@ -19,6 +19,36 @@
 //======================================================================================================
 #include <TaskSystem/TaskPipeline.h>
 #include <Misc/Atomic.h>
+#include <Misc/Timer.h>
+
+//======================================================================================================
+// 1回のExecuteの計測結果（時間はすべてマイクロ秒）
+//  フェーズはPushBarrierで区切られたジョブのまとまり
+//======================================================================================================
+struct TaskProfile
+{
+	struct Phase
+	{
+		const char*	pName;
+		fp64		WallTime;		// 前のバリアが開いてからこのフェーズのバリアが開くまで
+		fp64		BusyTime;		// フェーズ内のジョブの実行時間の合計
+		int32		JobCount;
+	};
+
+	struct Worker
+	{
+		int32		CoreNo;			// 0はExecuteを呼んだスレッド
+		fp64		BusyTime;		// ジョブの実行時間
+		fp64		BarrierTime;	// バリアで待っていた時間
+		fp64		IdleTime;		// それ以外（起床待ちやキューの取得など）
+		int32		JobCount;
+	};
+
+	int32				FrameNo;
+	fp64				FrameTime;
+	std::vector<Phase>	Phases;
+	std::vector<Worker>	Workers;
+};
 
 //======================================================================================================
 //
@@ -30,7 +60,12 @@ public:
 	{
 		std::function<void(void*)>	Callback;
 		void*						pData;
+		const char*					pLabel;
 		uint32						BarrierID;
+		int32						PhaseNo;
+		int32						CoreNo;
+		uint64						BeginTime;
+		uint64						EndTime;
 	};
 
 private:
@@ -43,8 +78,19 @@ private:
 		Atomic					WriteOffset;
 		Atomic					ReadOffset;
 		Atomic					RunningPipelineCount;
-		bool					IsTaskCompleted;
+		std::atomic_bool		IsTaskCompleted;
 		std::vector<Atomic>		BarrierCount;
+		std::vector<const char*>	PhaseNames;
+	};
+
+	struct TraceEvent
+	{
+		const char*	pName;
+		const char*	pPhase;
+		int32		CoreNo;
+		int32		Index;
+		uint64		BeginTime;
+		uint64		EndTime;
 	};
 
 private:
@@ -52,11 +98,24 @@ private:
 	int32						_PipelineCount;
 	TaskData					_TaskData;
 	Atomic						_ExecutePipelineCount;
+	Timer						_Timer;
+	bool						_IsProfileEnabled;
+	bool						_IsTimeStampEnabled;
+	TaskProfile					_Profile;
+	std::string					_TraceFileName;
+	int32						_TraceFrameCount;
+	int32						_TraceFrameNo;
+	std::vector<TraceEvent>		_TraceEvents;
 
 private:
-	TaskSystem() {}
+	TaskSystem() : _IsProfileEnabled(true), _IsTimeStampEnabled(false), _TraceFrameCount(0), _TraceFrameNo(0) {}
 	~TaskSystem() {}
 
+	void BeginFrame();
+	void EndFrame(uint64 BeginTime, uint64 EndTime);
+	void BuildProfile(uint64 BeginTime, uint64 EndTime);
+	void RecordTrace(uint64 BeginTime, uint64 EndTime);
+
 public:
 	void Initialize();
 	void Finalize();
@@ -64,11 +123,27 @@ public:
 	void ExecuteSingle();
 
 	bool GetQueData(QueData*& pQueData);
-	void ExecuteQue(QueData* pQueData);
+	void ExecuteQue(QueData* pQueData, int32 CoreNo);
 	void Completed(int32 CoreNo);
 
-	void PushQue(std::function<void(void*)> Callback, void* pData);
+	void PushQue(std::function<void(void*)> Callback, void* pData, const char* pLabel = nullptr);
 	void PushBarrier();
+	void SetPhaseName(const char* pName);
+
+	// ジョブを実行するスレッドの数（Executeを呼ぶスレッドを含む）
+	int32 GetWorkerCount() const { return _PipelineCount + 1; }
+	// 実行中のジョブのスレッド番号（0～GetWorkerCount()-1、0はExecuteを呼んだスレッド）
+	static int32 GetCurrentCoreNo();
+
+	void SetProfileEnabled(bool IsEnabled) { _IsProfileEnabled = IsEnabled; }
+	bool IsProfileEnabled() const { return _IsProfileEnabled; }
+	const TaskProfile& GetProfile() const { return _Profile; }
+
+	// 次のExecuteからFrameCount回分のジョブの実行記録を取りChrome trace形式のJSONで書き出す
+	// ラベルやフェーズ名は文字列リテラルを渡すこと（ポインタのまま保持する）
+	void BeginTrace(const char* pFileName, int32 FrameCount);
+	bool EndTrace();
+	bool IsTraceEnabled() const { return _TraceFrameCount > 0; }
 
 public:
 	static TaskSystem& Instance()